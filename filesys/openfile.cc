@@ -235,5 +235,13 @@ OpenFile::WriteStdout(char *from, int numBytes) {
 
 int 
 OpenFile::ReadStdin(char *into, int numBytes) {
-    return ReadPartial(0, into, numBytes);
+    // -replay: 用日志中记录的输入代替stdin
+    if (eventLog != NULL && eventLog->IsReplaying()
+            && eventLog->NextEvent(StdinEvent) >= 0)
+        return eventLog->Replay(StdinEvent, into, numBytes);
+    int numRead = ReadPartial(0, into, numBytes);
+    if (eventLog != NULL && eventLog->IsRecording())
+        eventLog->Record(StdinEvent, stats->totalTicks, into,
+                         numRead > 0 ? numRead : 0);
+    return numRead;
 }
\ No newline at end of file
@@ -107,3 +107,33 @@ SynchDisk::RequestDone()
 { 
     semaphore->V();
 }
+
+//----------------------------------------------------------------------
+// SynchDisk::Checkpoint, SynchDisk::Restore, and the same for the head
+// 	Save the raw disk to a checkpoint of the simulation, and read it
+//	back (see Disk::Checkpoint).
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Checkpoint(int fd)
+{
+    disk->Checkpoint(fd);
+}
+
+void
+SynchDisk::Restore(int fd)
+{
+    disk->Restore(fd);
+}
+
+void
+SynchDisk::CheckpointHead(int fd)
+{
+    disk->CheckpointHead(fd);
+}
+
+void
+SynchDisk::RestoreHead(int fd)
+{
+    disk->RestoreHead(fd);
+}
@@ -18,6 +18,8 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+EventLog *eventLog;			// log of the events from outside
+					// of Nachos, or NULL
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -80,6 +82,8 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    char *eventLogName = NULL;		// -record or -replay
+    bool replay = FALSE;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
@@ -108,6 +112,11 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+	    ASSERT(argc > 1);
+	    eventLogName = *(argv + 1);
+	    replay = !strcmp(*argv, "-replay");
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
@@ -136,6 +145,9 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    eventLog = NULL;
+    if (eventLogName != NULL)			// log external events, or
+	eventLog = new EventLog(eventLogName, replay);	// play them back
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
     if (randomYield)				// start the timer (if needed)
@@ -196,6 +208,7 @@ Cleanup()
 #endif
     
     delete timer;
+    delete eventLog;
     delete scheduler;
     delete interrupt;
     
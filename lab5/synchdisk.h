@@ -42,6 +42,12 @@ class SynchDisk {
 					// handler, to signal that the
 					// current disk operation is complete.
 
+    void Checkpoint(int fd);		// Save the disk to a UNIX file,
+    void Restore(int fd);		// and read it back; no request
+					// may be in progress
+    void CheckpointHead(int fd);	// Same for the position of the
+    void RestoreHead(int fd);		// disk head (see Disk::Checkpoint)
+
   private:
     Disk *disk;		  		// Raw disk device
     Semaphore *semaphore; 		// To synchronize requesting thread 
@@ -57,7 +57,7 @@ SwapHeader (NoffHeader *noffH)
 //	"executable" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
 
-BitMap AddrSpace::freePageMap(NumPhysPages);
+BitMap *AddrSpace::freePageMap = NULL;
 BitMap AddrSpace::freeUserProcessMap(MaxUserProcess);
 
 AddrSpace::AddrSpace(OpenFile *executable) {
@@ -82,23 +82,27 @@ AddrSpace::AddrSpace(OpenFile *executable) {
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+    ASSERT(numPages <= (unsigned) NumPhysPages);	// check we're not
+							// trying to run anything
+							// too big -- at least
+							// until we have virtual
+							// memory
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
 					numPages, size);
     // step1：创建用户页表, 建立虚拟页-实际帧映射
+    if (freePageMap == NULL)                                // 物理内存大小在运行时确定, 不能静态创建
+        freePageMap = new BitMap(NumPhysPages);
     pageTable = new TranslationEntry[numPages];
-    ASSERT(freePageMap.NumClear() >= numPages);            // 确定内存空闲帧足以分配给该程序
+    ASSERT(freePageMap->NumClear() >= numPages);            // 确定内存空闲帧足以分配给该程序
     for (i = 0; i < numPages; i++) {
         pageTable[i].virtualPage = i;
-        pageTable[i].physicalPage = freePageMap.Find();    // 修改virt - phys的映射, 寻找空闲物理帧作为映射
+        pageTable[i].physicalPage = freePageMap->Find();    // 修改virt - phys的映射, 寻找空闲物理帧作为映射
         pageTable[i].valid = TRUE;
         pageTable[i].use = FALSE;
         pageTable[i].dirty = FALSE;
         pageTable[i].readOnly = FALSE;                      // 只读选项, 当代码段完全占据一整个物理帧时设为只读
+        machine->InvalidateDecodedFrame(pageTable[i].physicalPage);   // 该帧将被重新装入, 丢弃旧的预译码指令
     }
 
     // 多线程情况下不清除machine的主存内容
@@ -113,6 +117,7 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 			physicalPageNumber + offset, noffH.code.size);
         executable->ReadAt(&(machine->mainMemory[physicalPageNumber + offset]),
 			noffH.code.size, noffH.code.inFileAddr);
+        machine->ConvertLoadedImage(physicalPageNumber + offset, noffH.code.size);  // 转为主存的字节序
     }
     if (noffH.initData.size > 0) {
         int physicalPageNumber = pageTable[noffH.initData.virtualAddr / PageSize].physicalPage * PageSize;
@@ -121,6 +126,30 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 			physicalPageNumber + offset, noffH.initData.size);
         executable->ReadAt(&(machine->mainMemory[physicalPageNumber + offset]),
 			noffH.initData.size, noffH.initData.inFileAddr);
+        machine->ConvertLoadedImage(physicalPageNumber + offset, noffH.initData.size);  // 转为主存的字节序
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	从检查点恢复地址空间: 读入Checkpoint写下的进程号和页表, 并在
+//	位图中占用它们; 页框的内容由Machine::Restore恢复.
+//
+//	"checkpoint" -- 已打开的检查点文件(UNIX文件)
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(int checkpoint) {
+    Read(checkpoint, (char *) &pid, sizeof(int));
+    Read(checkpoint, (char *) &numPages, sizeof(unsigned int));
+    ASSERT(!freeUserProcessMap.Test(pid - 100));
+    freeUserProcessMap.Mark(pid - 100);
+    if (freePageMap == NULL)
+        freePageMap = new BitMap(NumPhysPages);
+    pageTable = new TranslationEntry[numPages];
+    Read(checkpoint, (char *) pageTable, numPages * sizeof(TranslationEntry));
+    for (unsigned int i = 0; i < numPages; i++) {
+        ASSERT(!freePageMap->Test(pageTable[i].physicalPage));
+        freePageMap->Mark(pageTable[i].physicalPage);
     }
 }
 
@@ -130,9 +159,9 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace() {
-    freeUserProcessMap.Clear(pid);
+    freeUserProcessMap.Clear(pid - 100);                   // 与构造函数中的+100对应
     for (int i = 0; i < numPages; i++)
-        freePageMap.Clear(pageTable[i].physicalPage);
+        freePageMap->Clear(pageTable[i].physicalPage);
     delete [] pageTable;
 }
 
@@ -177,6 +206,15 @@ AddrSpace::InitRegisters()
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState() {
+    if (machine->tlb != NULL) {
+        // 使用TLB时页表不交给硬件, 只需把TLB中的use/dirty位写回用户页表
+        for (int i = 0; i < TLBSize; i++)
+            if (machine->tlb[i].valid) {
+                pageTable[machine->tlb[i].virtualPage].use = machine->tlb[i].use;
+                pageTable[machine->tlb[i].virtualPage].dirty = machine->tlb[i].dirty;
+            }
+        return;
+    }
     // 保存系统页表信息, 以便于线程上下文切换
     pageTable = machine->pageTable;
     numPages = machine->pageTableSize;
@@ -191,9 +229,43 @@ void AddrSpace::SaveState() {
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() {
-    // 该函数是多线程的关键函数, 其将用户页表映射为系统页表, 切换了进程上下文
-    machine->pageTable = pageTable;
-    machine->pageTableSize = numPages;
+    stats->SetProcess(pid);                          // 此后的TLB命中/缺失计入本进程
+    if (machine->tlb != NULL) {
+        // 使用TLB时, TLB中是上一个进程的表项, 全部作废, 由RefillTLB按需装入
+        for (int i = 0; i < TLBSize; i++)
+            machine->tlb[i].valid = FALSE;
+        // 内核复制用户内存时据此判断地址是否在地址空间内(见TranslateForCopy)
+        machine->refillTable = pageTable;
+        machine->refillTableSize = numPages;
+    } else {
+        // 该函数是多线程的关键函数, 其将用户页表映射为系统页表, 切换了进程上下文
+        machine->pageTable = pageTable;
+        machine->pageTableSize = numPages;
+    }
+    machine->FlushTranslationCache();                // 丢弃旧页表的地址转换缓存
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::RefillTLB
+// 	TLB缺失(PageFaultException)时由ExceptionHandler调用:
+//	用页表中virtAddr所在页的表项替换TLB中的一项(由Machine::TLBVictim
+//	按替换策略选出), 被替换表项的use/dirty位先写回页表.
+//	返回用户程序后, 缺失的指令会重新执行.
+//
+//	"virtAddr" -- 引起缺失的虚拟地址
+//----------------------------------------------------------------------
+
+void AddrSpace::RefillTLB(int virtAddr) {
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+
+    ASSERT(vpn < numPages && pageTable[vpn].valid);  // 不在地址空间内: 非法访问
+    TranslationEntry *entry = machine->TLBVictim(vpn);
+    if (entry->valid) {
+        pageTable[entry->virtualPage].use = entry->use;
+        pageTable[entry->virtualPage].dirty = entry->dirty;
+    }
+    *entry = pageTable[vpn];
+    machine->FlushTranslationCache();
 }
 
 
@@ -210,4 +282,20 @@ void AddrSpace::Print() {
 
 int AddrSpace::getPid() const {
     return this->pid;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Checkpoint
+// 	把进程号和页表写入已打开的检查点文件fd, 由AddrSpace(int)读回.
+//	使用TLB时, TLB中较新的use/dirty位由Machine::Checkpoint保存.
+//----------------------------------------------------------------------
+
+void AddrSpace::Checkpoint(int fd) {
+    WriteFile(fd, (char *) &pid, sizeof(int));
+    WriteFile(fd, (char *) &numPages, sizeof(unsigned int));
+    WriteFile(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+}
+
+int AddrSpace::NumProcesses() {
+    return MaxUserProcess - freeUserProcessMap.NumClear();
+}
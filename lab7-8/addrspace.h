@@ -23,19 +23,23 @@
 class AddrSpace {
   public:
     AddrSpace(OpenFile *executable);	// 初始化executable中程序的地址空间
+    AddrSpace(int checkpoint);        // 从检查点文件(已打开的UNIX文件)恢复地址空间
     ~AddrSpace();			                // 析构函数
 
     void InitRegisters();		          // 初始化用户线程寄存器
     void SaveState();			            // 保存地址空间状态
     void RestoreState();		          // 用户页表映射为系统页表
+    void RefillTLB(int virtAddr);     // TLB缺失时, 将virtAddr所在页的表项装入TLB
     void Print();                     // 输出页表相关信息：虚实页的映射等关系
     int getPid() const;               // 获取进程号
+    void Checkpoint(int fd);          // 把进程号和页表写入检查点文件
+    static int NumProcesses();        // 现有的用户进程数
 
   private:
     int pid;                          // 线程号
     TranslationEntry *pageTable;	    // 用户页表
     unsigned int numPages;		        // 页表表项个数
-    static BitMap freePageMap;       // 管理物理内存的空闲帧
+    static BitMap *freePageMap;      // 管理物理内存的空闲帧, 按-mem指定的帧数在首次使用时创建
     static BitMap freeUserProcessMap;// 管理空闲用户线程
 };
 
@@ -0,0 +1,184 @@
+// checkpoint.cc
+//	Routines to save the state of Nachos, with the user program it is
+//	running, to a UNIX file (-checkpoint), and to start a later run of
+//	Nachos from that state instead of from scratch (-restore).
+//
+//	The state saved is that of the simulated hardware -- registers,
+//	main memory, TLB, pending interrupts, the disk, the statistics and
+//	the random number generator -- and the kernel data the process
+//	needs (its page table, pid, priority and PCB).  Kernel threads
+//	can't be saved (their stacks hold addresses in this run of Nachos),
+//	so a checkpoint is only taken when there is just one user process,
+//	the one started by -x, running on the main thread, with no Nachos
+//	files open; it is taken as one of its system calls returns, and
+//	the restored program goes on from there.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+
+#define CheckpointMagic	0x4e434b50	// "NCKP"
+
+// 检查点文件开头记录机器的配置, 恢复时必须用同样的配置运行
+struct CheckpointHeader {
+    int magic;
+    int numPhysPages;       // -mem
+    int tlbSize;            // -tlb
+    int tlbAssoc;           // -tlbassoc
+    int tlbReplacement;     // -tlbpolicy
+};
+
+//----------------------------------------------------------------------
+// MakeHeader
+// 	按当前的机器配置填写检查点文件头.
+//----------------------------------------------------------------------
+
+static void
+MakeHeader(CheckpointHeader *header)
+{
+    header->magic = CheckpointMagic;
+    header->numPhysPages = NumPhysPages;
+    header->tlbSize = TLBSize;
+    header->tlbAssoc = TLBAssoc;
+    header->tlbReplacement = (int) TLBReplacement;
+}
+
+//----------------------------------------------------------------------
+// CanCheckpoint
+// 	现在能否保存检查点: 单处理机, 只有一个用户进程(即-x启动的, 运行
+//	在main线程上的进程), 没有线程在闹钟中睡眠(它们不在检查点中), 且
+//	这个进程没有打开Nachos文件.
+//----------------------------------------------------------------------
+
+static bool
+CanCheckpoint()
+{
+    if (numCPUs > 1 || AddrSpace::NumProcesses() != 1)
+        return FALSE;
+    if (!alarmClock->IsIdle())                  // 还有线程睡眠, 或闹钟中断未到
+        return FALSE;
+    if (currentThread->pcb->parentPid >= 100)   // 是Exec创建的进程
+        return FALSE;
+#ifdef FILESYS
+    for (int i = 3; i < MaxFileId; i++)
+        if (currentThread->pcb->files[i] != NULL)
+            return FALSE;
+#endif
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Checkpoint
+// 	在用户进程的系统调用处理完、返回用户程序之前(ExceptionHandler)
+//	调用, 把状态保存到UNIX文件name中.  此时PC已指向下一条指令, 但
+//	syscall指令本身的时钟周期还没有计入.
+//
+//	返回是否保存了检查点; 现在不能保存时返回FALSE, 以后的系统调用
+//	再试.
+//----------------------------------------------------------------------
+
+bool
+Checkpoint(char *name)
+{
+    CheckpointHeader header;
+    unsigned int seed, calls;
+    int priority, fd;
+
+    if (!CanCheckpoint())
+        return FALSE;
+    fd = OpenForWrite(name);
+    if (fd < 0) {
+        printf("Unable to create checkpoint %s\n", name);
+        return TRUE;                            // 不再尝试
+    }
+    MakeHeader(&header);
+    WriteFile(fd, (char *) &header, sizeof(CheckpointHeader));
+#ifdef FILESYS
+    synchDisk->Checkpoint(fd);
+#endif
+    currentThread->pcb->space->Checkpoint(fd);
+    WriteFile(fd, (char *) &currentThread->pcb->parentPid, sizeof(int));
+    WriteFile(fd, (char *) &currentThread->pcb->waitProcessPid, sizeof(int));
+    WriteFile(fd, (char *) &currentThread->pcb->waitProcessExitCode, sizeof(int));
+    WriteFile(fd, (char *) &currentThread->pcb->exitCode, sizeof(int));
+    priority = currentThread->getPriority();
+    WriteFile(fd, (char *) &priority, sizeof(int));
+    machine->Checkpoint(fd);
+#ifdef FILESYS
+    synchDisk->CheckpointHead(fd);
+#endif
+    interrupt->Checkpoint(fd);
+    stats->Checkpoint(fd);
+    RandomGetState(&seed, &calls);
+    WriteFile(fd, (char *) &seed, sizeof(unsigned int));
+    WriteFile(fd, (char *) &calls, sizeof(unsigned int));
+    Close(fd);
+    printf("Checkpoint %s written at time %d\n", name, stats->totalTicks);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RestoreProcess
+// 	从检查点文件name恢复状态, 并接着运行其中的用户进程(-restore),
+//	代替StartProcess.  须在启动时(main线程上还没有运行用户程序)调用,
+//	且-mem, -tlb等选项, 以及是否有-rs, 须与保存检查点时相同.
+//
+//	启动过程中花的时间, 和启动时的统计数据一样, 都被检查点中的覆盖.
+//----------------------------------------------------------------------
+
+void
+RestoreProcess(char *name)
+{
+    CheckpointHeader header, expected;
+    unsigned int seed, calls;
+    int priority;
+    AddrSpace *space;
+    int fd = OpenForReadWrite(name, FALSE);
+
+    if (fd < 0) {
+        printf("Unable to open checkpoint %s\n", name);
+        return;
+    }
+    ASSERT(currentThread->pcb->space == NULL && numCPUs == 1);
+    Read(fd, (char *) &header, sizeof(CheckpointHeader));
+    MakeHeader(&expected);
+    if (bcmp((char *) &header, (char *) &expected, sizeof(CheckpointHeader))) {
+        printf("Checkpoint %s was taken with other -mem or -tlb options\n", name);
+        Close(fd);
+        return;
+    }
+#ifdef FILESYS
+    synchDisk->Restore(fd);
+    delete fileSystem;                          // 重新读入磁盘上的位图和目录
+    fileSystem = new FileSystem(FALSE);
+#endif
+    space = new AddrSpace(fd);
+    currentThread->pcb->space = space;
+    Read(fd, (char *) &currentThread->pcb->parentPid, sizeof(int));
+    Read(fd, (char *) &currentThread->pcb->waitProcessPid, sizeof(int));
+    Read(fd, (char *) &currentThread->pcb->waitProcessExitCode, sizeof(int));
+    Read(fd, (char *) &currentThread->pcb->exitCode, sizeof(int));
+    Read(fd, (char *) &priority, sizeof(int));
+    currentThread->setPriority(priority);
+    space->RestoreState();                      // 先装入页表, 再恢复TLB的内容
+    machine->Restore(fd);
+#ifdef FILESYS
+    synchDisk->RestoreHead(fd);                 // 重建文件系统时磁头移动过
+#endif
+    interrupt->Restore(fd);
+    stats->Restore(fd);
+    Read(fd, (char *) &seed, sizeof(unsigned int));
+    Read(fd, (char *) &calls, sizeof(unsigned int));
+    RandomSetState(seed, calls);
+    Close(fd);
+    printf("Checkpoint %s restored at time %d\n", name, stats->totalTicks);
+
+    interrupt->setStatus(UserMode);             // 像Machine::RaiseException返回后一样,
+    interrupt->OneTick();                       // 计入syscall指令的时间, 处理到期的中断
+    machine->Run();
+    ASSERT(FALSE);
+}
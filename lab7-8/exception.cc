@@ -25,9 +25,17 @@
 #include "system.h"
 #include "syscall.h"
 
-void StartProcess(int pid);
+void StartProcess(_int pid);
 void IncrementPC();
-void ReadMem(int addr, char *fileName, int size);
+void ReadString(int addr, char *buffer, int size);
+bool Checkpoint(char *name);
+
+// 系统调用的名字, 按SC_*的编号, 用于-trace
+static const char *syscallNames[] = { "Halt", "Exit", "Exec", "Join", "Create",
+        "Open", "Read", "Write", "Close", "Fork", "Yield", "SetPriority",
+        "ExecShare" };
+#define NumSyscallNames (int) (sizeof(syscallNames) / sizeof(const char *))
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -57,6 +65,14 @@ ExceptionHandler(ExceptionType which)
     int type = machine->ReadRegister(2);
 
     if (which == SyscallException) {
+        // -trace: 系统调用在调用线程的轨道上记为一段, Exit和Halt不返回, 只有开始
+        const char *name = (type >= 0 && type < NumSyscallNames) ?
+                        syscallNames[type] : "unknown";
+        int track = 0;
+        if (tracer != NULL) {
+            track = tracer->ThreadTrack(currentThread);
+            tracer->Begin(track, "syscall", name);
+        }
         // 处理system call exception
         switch (type) {
             case SC_Halt: {
@@ -76,10 +92,10 @@ ExceptionHandler(ExceptionType which)
                 DEBUG('x', "Write exitCode back to r2\n");
                 // 设置thread的退出码
                 currentThread->pcb->exitCode = exitCode;
-                // 处理非Fork线程
+                // 处理非Fork线程: 回收没有被Join的子进程
                 if (currentThread->pcb->parentPid < 100) {
-                    scheduler->emptyList(scheduler->getTerminatedList());
-                    DEBUG('x', "Non-Forked Thread, empty terminated list.\n");
+                    scheduler->ReapChildren(currentThread->getPid());
+                    DEBUG('x', "Non-Forked Thread, reap its terminated children.\n");
                 }
                 // 释放该线程的地址空间和pid
                 currentThread->Finish();
@@ -88,16 +104,24 @@ ExceptionHandler(ExceptionType which)
                 IncrementPC();
                 break;
             }
-            case SC_Exec: {
+            case SC_Exec:
+            case SC_ExecShare: {
                 DEBUG('x', "Exec, initiated by user program.\n");
-                printf("SC_Exec: system call\n");
+                printf("%s: system call\n", (type == SC_Exec) ? "SC_Exec" : "SC_ExecShare");
+                // ExecShare的第二个参数是新进程的彩票数, 用于stride调度
+                int tickets = (type == SC_Exec) ? DefaultTickets : machine->ReadRegister(5);
+                if (tickets < 1 || tickets > MaxTickets) {
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
                 // scheduler->Print();
                 // 获得exec程序中Exec系统调用函数的参数
    	            int addr = machine->ReadRegister(4);        
                 // 由于此处参数是字符串, r4寄存器存储该字符串在内存中的地址, 因此需要访存读出
                 // char fileName[FileNameMaxLen + 1];   Nachos中的文件长度应该限制在FileNameMaxLen, 此处为了适应unix文件系统, 直接使用50作为长度
                 char fileName[64];
-                ReadMem(addr, fileName, 64);
+                ReadString(addr, fileName, 64);
                 // 从内存读取待执行的程序
                 if (strcmp(fileName, "ls") == 0) {
                     DEBUG('x', "thread:%s\tFile(s) on Nachos DISK:\n", currentThread->getName());
@@ -122,9 +146,11 @@ ExceptionHandler(ExceptionType which)
                 printf("SC_Exec: parentPid = %d\n", currentThread->getPid());
                 // 设置新建线程的parentPid = 当前线程的pid
                 thread->pcb->parentPid = currentThread->getPid();
+                scheduler->AddProcess(thread);          // 登记到进程表, 以便Join
+                scheduler->SetTickets(thread, tickets);
                 // 输出该进程的页表信息, for debugging
                 space->Print();
-                // 此处Fork的参数要求为int, 如果要传char *, 要么重载Fork, 要么重载StartProcess, 我们选择简单的重载StartProcess
+                // 此处Fork的参数要求为_int(64位宿主机上是long), 如果要传char *, 要么重载Fork, 要么重载StartProcess, 我们选择简单的重载StartProcess
                 // 还有一种解决思路, 将char *转换成int传递给Fork, 两者均为4字节;
                 thread->Fork(StartProcess, space->getPid());
                 // currentThread->Yield();      // 去掉这个就会报段错误, 为啥呢？
@@ -155,6 +181,23 @@ ExceptionHandler(ExceptionType which)
                 IncrementPC();
                 break;
             }
+            case SC_SetPriority: {
+                DEBUG('x', "SetPriority, initiated by user program.\n");
+                printf("SC_SetPriority: system call\n");
+                int priority = machine->ReadRegister(4);
+                int oldPriority = currentThread->getPriority();
+                if (priority < 0 || priority >= NumPriorities) {
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
+                currentThread->setPriority(priority);
+                machine->WriteRegister(2, oldPriority);     // 返回原来的优先级
+                if (priority > oldPriority)                 // 降低了优先级, 让更重要的就绪进程运行
+                    currentThread->Yield();
+                IncrementPC();
+                break;
+            }
             case SC_Create: {
                 DEBUG('x', "Create, initiated by user program.\n");
                 printf("SC_Create: system call\n");
@@ -163,7 +206,7 @@ ExceptionHandler(ExceptionType which)
                 printf("Addr: %d\n", addr);
                 // 读取文件
                 char fileName[64];
-                ReadMem(addr, fileName, 64);
+                ReadString(addr, fileName, 64);
 #ifdef FILESYS_STUB
                 // 打开文件, 不存在则新建, 存在则清空覆盖
                 int fd = OpenForWrite(fileName);
@@ -188,7 +231,7 @@ ExceptionHandler(ExceptionType which)
                 int addr = machine->ReadRegister(4);
                 printf("Addr: %d\n", addr);
                 char fileName[64];
-                ReadMem(addr, fileName, 64);
+                ReadString(addr, fileName, 64);
 #ifdef FILESYS_STUB
                 int fd = OpenForReadWrite(fileName, true);
                 if (fd == -1)
@@ -212,9 +255,22 @@ ExceptionHandler(ExceptionType which)
                 int size = machine->ReadRegister(5);
                 int fd = machine->ReadRegister(6);
                 printf("Addr: %d, length: %d, fd: %d\n", addr, size, fd);
-                // 从内存读取buffer的内容
-                char buffer[128];
-                ReadMem(addr, buffer, size);
+                if (size < 0) {     // 长度非法, 不分配buffer
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
+                // 从内存读取buffer的内容, 按页整块复制, 长度不受限制
+                char *buffer = new char[size + 1];
+                if (!machine->CopyFromUser(addr, buffer, size)) {
+                    // 用户地址非法: 返回-1, 不终止内核
+                    printf("Reading Memory Error Occurred at %d.\n", machine->ReadRegister(BadVAddrReg));
+                    delete [] buffer;
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
+                buffer[size] = '\0';
 #ifdef FILESYS_STUB
                 // 打开fd对应文件
                 OpenFile *openfile = new OpenFile(fd);
@@ -240,6 +296,7 @@ ExceptionHandler(ExceptionType which)
                         printf("\"%s\" has written in file %d succeed!\n", buffer, fd);
                 }
 #endif
+                delete [] buffer;
                 machine->WriteRegister(2, size);
                 IncrementPC();
                 break;
@@ -251,29 +308,45 @@ ExceptionHandler(ExceptionType which)
                 int size = machine->ReadRegister(5);
                 int fd = machine->ReadRegister(6);
                 printf("Addr: %d, length: %d, fd: %d\n", addr, size, fd);
+                if (size < 0) {     // 长度非法, 不分配buffer
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
 #ifdef FILESYS_STUB
                 // 打开fd对应文件
                 OpenFile *openfile = new OpenFile(fd);
                 ASSERT(openfile != NULL);
-                // 从内存读取buffer的内容
-                char buffer[size];
+                // 读入buffer后按页整块写回用户内存
+                char *buffer = new char[size + 1];
                 int readBytes = openfile->Read(buffer, size);
-                for (int i = 0; i < size; i++)
-                    if (!machine->WriteMem(addr, 1, buffer[i]))
-                        printf("Writing Memory ErrorOccurred.\n");
+                if (!machine->CopyToUser(addr, buffer, readBytes)) {
+                    // 用户地址非法: 返回-1, 而不是读到的字节数
+                    printf("Writing Memory Error Occurred at %d.\n", machine->ReadRegister(BadVAddrReg));
+                    delete [] buffer;
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
                 buffer[readBytes] = '\0';
                 printf("Read succeed, contents: %s, length = %d.\n", buffer, readBytes);
 #else
                 OpenFile *openfile = currentThread->pcb->getOpenFile(fd);
                 ASSERT(openfile != NULL);
-                char buffer[size];
+                char *buffer = new char[size + 1];
                 int readBytes = 0;
                 if (fd == 0) //stdin
                     readBytes = openfile->ReadStdin(buffer, size);
                 else
                     readBytes = openfile->ReadFromStart(buffer, size);
-                for (int i = 0; i < readBytes; i++)
-                    machine->WriteMem(addr, 1, buffer[i]);
+                if (!machine->CopyToUser(addr, buffer, readBytes)) {
+                    // 用户地址非法: 返回-1, 而不是读到的字节数
+                    printf("Writing Memory Error Occurred at %d.\n", machine->ReadRegister(BadVAddrReg));
+                    delete [] buffer;
+                    machine->WriteRegister(2, -1);
+                    IncrementPC();
+                    break;
+                }
                 buffer[readBytes]='\0';
                 
                 for(int i = 0; i < readBytes; i++)
@@ -285,6 +358,7 @@ ExceptionHandler(ExceptionType which)
                 else
                     printf("Read file failed!\n");
 #endif
+                delete [] buffer;
                 machine->WriteRegister(2, readBytes);
                 IncrementPC();
                 break;
@@ -313,6 +387,16 @@ ExceptionHandler(ExceptionType which)
 	            ASSERT(FALSE);
             }
         }
+        if (tracer != NULL)
+            tracer->End(track, "syscall", name);
+        // -checkpoint: 到时间后, 在第一个能保存检查点的系统调用完成时保存一次
+        if (checkpointFile != NULL && stats->totalTicks >= checkpointTime
+                                   && Checkpoint(checkpointFile))
+            checkpointFile = NULL;
+    } else if (which == PageFaultException && machine->tlb != NULL) {
+        // TLB缺失: 装入页表项后返回, 不更新PC, 重新执行该指令
+        DEBUG('a', "TLB miss at 0x%x.\n", machine->ReadRegister(BadVAddrReg));
+        currentThread->pcb->space->RefillTLB(machine->ReadRegister(BadVAddrReg));
     } else {
         // 处理其他 exception: addressing exception 或者 arithmetic exception等
         printf("Unexpected user mode exception %d %d\n", which, type);
@@ -324,10 +408,9 @@ ExceptionHandler(ExceptionType which)
  * 重载的StartProcess函数, 以适应Fork传参为整数
  */ 
 void
-StartProcess(int pid) {
-    // 此时地址空间已经建立, 只需要初始化寄存器, 调度执行程序即可
-    currentThread->pcb->space->InitRegisters();  // 初始化寄存器
-    currentThread->pcb->space->RestoreState();   // 恢复页表信息
+StartProcess(_int pid) {
+    // 此时地址空间已经建立, 寄存器和页表也在线程开始运行、开中断之前
+    // 装好了(见thread.cc中的InterruptEnable), 直接运行程序即可
     machine->Run();     // 运行用户程序
     ASSERT(FALSE);
 }
@@ -346,11 +429,14 @@ IncrementPC() {
     machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg) + 4);    // 更新NextPC = NextPC + 4
 }
 
+/**
+ * ReadString, 从用户内存addr处读取以'\0'结尾的字符串(如文件名)到buffer,
+ * buffer长度为size; 由machine按页整块复制, TLB缺失由machine转交ExceptionHandler处理
+ */
 void
-ReadMem(int addr, char *buffer, int size) {
-    for (int i = 0; i < size; i++) {
-        machine->ReadMem(addr + i, 1, (int *)&buffer[i]);
-        if (buffer[i] == '\0')
-            break;
+ReadString(int addr, char *buffer, int size) {
+    if (machine->CopyStringFromUser(addr, buffer, size) < 0) {
+        printf("Unable to read string at %d\n", addr);
+        ASSERT(FALSE);
     }
 }
\ No newline at end of file
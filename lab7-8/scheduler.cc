@@ -11,8 +11,25 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The thread of the highest priority runs first; threads of the
+//	same priority run in FIFO order.  A thread woken by an interrupt
+//	handler preempts the interrupted thread if it is more important.
+//
+//	Under the multilevel feedback queue (-sched mlfq), the scheduler
+//	sets the priorities itself: threads that use up their quantum
+//	sink, and threads that give up the CPU early (waiting for I/O)
+//	stay near the top.  Under stride scheduling (-sched stride),
+//	threads share the CPU in proportion to their tickets instead,
+//	and the share each was entitled to is reported with the share it
+//	got.  The time each thread runs and waits is kept under every
+//	policy.
+//
+//	多处理机(-cpus N)时, 每个CPU有自己的就绪队列, 线程就绪时回到上次
+//	运行它的CPU; 某个CPU的队列空了, 就从其他CPU的队列中取.
+//	N个CPU在同一个宿主机线程上轮流运行, 每次一个时间片(见NextCPU),
+//	只在开中断(或执行一条用户指令)时才会换到别的CPU, 这和单处理机上
+//	时间片到期引起的线程切换一样; 所以关中断仍然能保证互斥, 内核的
+//	数据结构不需要另加自旋锁.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -22,17 +39,41 @@
 #include "scheduler.h"
 #include "system.h"
 
+// 用"make HOST64=1 SAVEALL=1"编译时(见Makefile.dep), 每次切换都保存用户态
+// 寄存器, 即懒保存之前的做法, 用来和-sb比较
+#ifdef SAVE_ALL
+#define LazyUserSave	FALSE
+#else
+#define LazyUserSave	TRUE
+#endif
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//
+//	"how" is the scheduling policy.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicy how)
 { 
-    readyList = new List("Ready"); 
+    for (int i = 0; i < MaxCPUs; i++)
+        readyList[i] = new ReadyQueue(how == StrideSched); 
+    policy = how;
+    chargeStart = chargeIdle = 0;
+    boosts = 0;
+    nextBoost = MLFQBoostTicks;
+    globalPass = 0;
+    virtualTime = 0;
+    competingTickets = 0;
 #ifdef USER_PROGRAM
-    terminatedList = new List("Terminated");
-    waitingList = new List("Waiting");
+    for (int i = 0; i < MaxCPUs; i++)
+        onCPU[i] = NULL;
+    cpu = 0;
+    roundStart = roundEnd = sliceEnd = 0;
+    slicing = FALSE;
+    userThread = NULL;
+    for (int i = 0; i < MaxUserProcess; i++)
+        processes[i] = NULL;
 #endif
 } 
 
@@ -43,20 +84,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList;
+    for (int i = 0; i < MaxCPUs; i++)
+        delete readyList[i];
     DEBUG('t', "deleted readyList\n");
-#ifdef USER_PROGRAM
-    if (terminatedList) {
-        delete terminatedList;
-        terminatedList = NULL;
-    }
-    DEBUG('t', "deleted terminatedList\n");
-    if (waitingList) {
-        delete waitingList;
-        waitingList = NULL;
-    }
-    DEBUG('t', "deleted waitingList\n");
-#endif
 } 
 
 //----------------------------------------------------------------------
@@ -71,9 +101,35 @@ void
 Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
+    if (schedStats != NULL)
+	schedStats->Ready(thread);
 
+    if (thread == currentThread)	// yielding: it may have used up
+	(void) Charge();		// its quantum
+    else if (policy == MLFQSched)
+	Refresh(thread);
+    else if (policy == StrideSched) {
+	if (thread->pass < globalPass)	// no credit for time away
+	    thread->pass = globalPass;
+	StartShare(thread);
+    }
+    thread->readySince = stats->totalTicks;
+    if (thread->firstReady < 0)
+	thread->firstReady = stats->totalTicks;
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+#ifdef USER_PROGRAM
+    int which = ChooseCPU(thread);
+
+    readyList[which]->Append(thread);
+    if (numCPUs > 1 && !slicing)
+        StartSlice(CPUSlice);       // 若有空闲的CPU, 最迟一个时间片后由它运行
+    if (which != cpu)               // 只抢占本CPU上被中断的线程
+        return;
+#else
+    readyList[0]->Append(thread);
+#endif
+    if (interrupt->InHandler() && Before(thread, currentThread))
+	interrupt->YieldOnReturn();	// preempt the interrupted thread
 }
 
 //----------------------------------------------------------------------
@@ -87,7 +143,51 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+#ifdef USER_PROGRAM
+    return FindNextToRun(cpu);
+#else
+    return readyList[0]->Remove();
+#endif
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldYield
+// 	Return TRUE if the thread FindNextToRun would return is not to run
+//	after the running thread: it has the same or a higher priority
+//	(under stride scheduling, the same or a smaller pass).  Used by
+//	Thread::Yield to keep the CPU when only less important threads
+//	are ready, and by TimerTick.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldYield ()
+{
+    Thread *next = NULL;
+
+#ifdef USER_PROGRAM
+    for (int i = 0; next == NULL && i < numCPUs; i++)   // 与FindNextToRun(cpu)的顺序相同
+        next = readyList[(cpu + i) % numCPUs]->Top();
+#else
+    next = readyList[0]->Top();
+#endif
+    return (next != NULL) && !Before(currentThread, next);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveReady
+// 	Take a thread off the ready list (its priority is being changed).
+//	Return FALSE if it was not there.
+//
+//	"thread" is the thread to be taken off the ready list.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::RemoveReady (Thread *thread)
+{
+    for (int i = 0; i < MaxCPUs; i++)
+        if (readyList[i]->Remove(thread))
+            return TRUE;
+    return FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -110,20 +210,43 @@ Scheduler::Run (Thread *nextThread)
     Thread *oldThread = currentThread;
     
 #ifdef USER_PROGRAM			// ignore until running user programs 
+    // 用户态寄存器懒保存: 单CPU时, 离开CPU的用户线程的寄存器先留在
+    // machine中(userThread), 到别的用户线程要用machine时才保存; 中间
+    // 只运行了内核线程, 或者回到的就是它自己时, 就不用保存和恢复了.
+    // 已结束的线程不会再运行, 不用保存.  多CPU时线程可能换到别的CPU
+    // 上运行, 仍然每次都保存.
     if (currentThread->pcb->space != NULL) {	// if this thread is a user program,
         if (DebugIsEnabled('s'))
             machine->DumpState();
-        currentThread->pcb->SaveUserState(); // save the user's CPU registers
-	    currentThread->pcb->space->SaveState();
+        if (numCPUs > 1 || !LazyUserSave) {
+            currentThread->pcb->SaveUserState(); // save the user's CPU registers
+	        currentThread->pcb->space->SaveState();
+            DEBUG('t', "Save user program state.\n");
+        } else if (currentThread->status != TERMINATED)
+            userThread = currentThread;
+    }
+    if (userThread != NULL && userThread != nextThread
+            && nextThread->pcb->space != NULL) {
+        userThread->pcb->SaveUserState();
+        userThread->pcb->space->SaveState();
+        userThread = NULL;
         DEBUG('t', "Save user program state.\n");
     }
 #endif
     
+    (void) Charge();			    // the time is now the new thread's
+    if (schedStats != NULL)
+	schedStats->Stopped(oldThread);
+    Dispatch(nextThread, stats->totalTicks);
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+#ifdef USER_PROGRAM
+    onCPU[cpu] = nextThread;
+    nextThread->lastCPU = cpu;
+#endif
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\".\n",
 	  oldThread->getName(), nextThread->getName());
@@ -153,20 +276,286 @@ Scheduler::Run (Thread *nextThread)
     }
     
 #ifdef USER_PROGRAM
-    if (currentThread->pcb->space != NULL) {		// if there is an address space
-        currentThread->pcb->RestoreUserState();     // to restore, do it.
-	    currentThread->pcb->space->RestoreState();
-        if (DebugIsEnabled('s')) {
-            currentThread->pcb->space->Print();
-            machine->DumpState();
-        }
-        DEBUG('t', "Restore user program state.\n");
-    }
-    if (DebugIsEnabled('t'))
-        Print();
+    Resume();
 #endif
 }
 
+//----------------------------------------------------------------------
+// Scheduler::TimerTick
+// 	Called by the timer interrupt handler.  Under fixed priorities,
+//	every timer interrupt is a time slice (-rs); under the multilevel
+//	feedback queue, the running thread is charged for its time, and
+//	is told to give up the CPU only if its quantum is up.  This is
+//	also where every thread is moved back up, when it is time.  Under
+//	stride scheduling, the running thread is charged, and gives up the
+//	CPU if its pass is no longer the smallest.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::TimerTick()
+{
+    if (policy == PrioritySched)
+	return TRUE;
+    if (policy == StrideSched) {
+	(void) Charge();
+	return ShouldYield();
+    }
+    if (stats->totalTicks >= nextBoost)
+	Boost();
+    return Charge();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Charge the running thread for the time since it was last charged,
+//	not counting the time the CPU was idle (the thread was asleep).
+//	Under the multilevel feedback queue, the time also counts toward
+//	the quantum of its level; once that is used up, the thread moves
+//	down a level, with a new quantum.  Under stride scheduling, it
+//	moves the thread's pass on, and the virtual time (the ticks run
+//	for each ticket competing) that the shares are worked out from.
+//
+//	Returns TRUE if the thread has used up its quantum.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Charge()
+{
+    Thread *thread = currentThread;
+    int ticks = (stats->totalTicks - chargeStart) 
+				- (stats->idleTicks - chargeIdle);
+    int level;
+
+    chargeStart = stats->totalTicks;
+    chargeIdle = stats->idleTicks;
+    if (ticks < 0)
+	ticks = 0;
+    thread->ticksUsed += ticks;
+    if (policy == StrideSched) {
+	if (thread->status == RUNNING)	// the first thread never became
+	    StartShare(thread);		// ready
+	thread->pass += (long long) ticks * (StrideLarge / thread->tickets);
+	if (thread->shareStart >= 0)
+	    virtualTime += (double) ticks / competingTickets;
+    }
+    if (policy != MLFQSched)
+	return FALSE;
+    Refresh(thread);
+    thread->quantumUsed += ticks;
+    level = thread->priority;
+    if (level >= MLFQLevels)		// put below the queue by setPriority
+	level = MLFQLevels - 1;
+    if (thread->quantumUsed < MLFQQuantum(level))
+	return FALSE;
+    DEBUG('t', "Thread \"%s\" used up its quantum at level %d\n",
+	thread->getName(), thread->priority);
+    if (thread->priority < MLFQLevels - 1)
+	thread->priority++;
+    thread->quantumUsed = 0;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Refresh
+// 	Under the multilevel feedback queue, put a thread that has not
+//	been placed since the last boost (or ever) at the top level, with
+//	a new quantum.  Threads that are not on the ready list when the
+//	boost happens are moved up this way when they next run or become
+//	ready.
+//
+//	"thread" is the thread to check.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Refresh(Thread *thread)
+{
+    if (thread->boostEpoch == boosts)
+	return;
+    thread->priority = 0;
+    thread->quantumUsed = 0;
+    thread->boostEpoch = boosts;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost
+// 	Under the multilevel feedback queue, move every thread back up to
+//	the top level, so that threads that have sunk get to run, and
+//	threads whose behavior has changed are placed afresh.  Threads on
+//	the ready list move now, in the order they would have run; the
+//	others when they next run or become ready (see Refresh).
+//----------------------------------------------------------------------
+
+void
+Scheduler::Boost()
+{
+    List moved;
+    Thread *thread;
+
+    boosts++;
+    nextBoost = stats->totalTicks + MLFQBoostTicks;
+    DEBUG('t', "Moving every thread up to the top level\n");
+    for (int i = 0; i < MaxCPUs; i++) {
+	while ((thread = readyList[i]->Remove()) != NULL)
+	    moved.Append((void *) thread);
+	while ((thread = (Thread *) moved.Remove()) != NULL) {
+	    Refresh(thread);
+	    readyList[i]->Append(thread);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	Count the time a thread waited on the ready list, as it is about
+//	to run; the first time, this is also its response time.  Under
+//	stride scheduling, its pass is where threads coming back start.
+//
+//	"thread" is the thread about to run.
+//	"when" is the time it starts running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch(Thread *thread, int when)
+{
+    if (when > thread->readySince)
+	thread->waitTicks += when - thread->readySince;
+    if (thread->responseTicks < 0 && thread->firstReady >= 0)
+	thread->responseTicks = (when > thread->firstReady) ? 
+					when - thread->firstReady : 0;
+    thread->dispatches++;
+    if (schedStats != NULL)
+	schedStats->Dispatched(thread, when,
+	    (when > thread->readySince) ? when - thread->readySince : 0);
+    if (thread->pass > globalPass)
+	globalPass = thread->pass;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Finished
+// 	Charge a thread that is finishing for the last of its time, and,
+//	under the multilevel feedback queue or stride scheduling, keep its
+//	times (and share) to be printed with the other statistics.
+//
+//	"thread" is the thread that is finishing; it must be running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Finished(Thread *thread)
+{
+    ASSERT(thread == currentThread);
+    (void) Charge();
+    EndShare(thread);
+    if (policy != PrioritySched)
+	stats->CountThread(thread->getName(), thread->ticksUsed, 
+	    thread->waitTicks, 
+	    (thread->responseTicks < 0) ? 0 : thread->responseTicks,
+	    thread->dispatches, 
+	    (policy == StrideSched) ? thread->tickets : 0,
+	    (int) thread->entitledTicks);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Blocked
+// 	Charge a thread that is going to sleep for the last of its time,
+//	before the CPU goes idle or to another thread; under stride
+//	scheduling, it stops competing for the CPU until it is ready
+//	again.  Its time slice ends here (for -schedstats), not in Run.
+//	Called by Thread::Sleep.
+//
+//	"thread" is the thread going to sleep; it must be running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Blocked(Thread *thread)
+{
+    ASSERT(thread == currentThread);
+    if (schedStats != NULL)
+	schedStats->Stopped(thread);
+    if (policy != StrideSched)
+	return;				// Run will charge it
+    (void) Charge();
+    EndShare(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetTickets
+// 	Give a thread a new number of tickets, for stride scheduling.  If
+//	it is competing for the CPU, its share so far is worked out with
+//	the old number.  Its pass stays where it is, so a thread that is
+//	ready keeps its place on the ready list.
+//
+//	"thread" is the thread to change.
+//	"tickets" is its new number of tickets, 1 to MaxTickets.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetTickets(Thread *thread, int tickets)
+{
+    bool competing = (thread->shareStart >= 0);
+
+    ASSERT(tickets > 0 && tickets <= MaxTickets);
+    if (competing) {
+	if (thread == currentThread)
+	    (void) Charge();		// at the old rate
+	EndShare(thread);
+    }
+    thread->tickets = tickets;
+    if (competing)
+	StartShare(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Before
+// 	Return TRUE if thread "a" is to run before thread "b": it has a
+//	higher priority, or, under stride scheduling, a smaller pass.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Before(Thread *a, Thread *b)
+{
+    if (policy == StrideSched)
+	return (a->pass < b->pass);
+    return (a->priority < b->priority);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StartShare
+// 	Under stride scheduling, count a thread among those competing for
+//	the CPU, from now on: as the virtual time goes on, it is entitled
+//	to its tickets' worth of the time run.  Nothing is done if it
+//	already is.
+//
+//	"thread" is the thread that is ready, or running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartShare(Thread *thread)
+{
+    if (policy != StrideSched || thread->shareStart >= 0)
+	return;
+    thread->shareStart = virtualTime;
+    competingTickets += thread->tickets;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndShare
+// 	Stop counting a thread among those competing for the CPU, adding
+//	what it was entitled to while it was to its total.
+//
+//	"thread" is the thread that is blocking or finishing.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndShare(Thread *thread)
+{
+    if (policy != StrideSched || thread->shareStart < 0)
+	return;
+    thread->entitledTicks += thread->tickets 
+				* (virtualTime - thread->shareStart);
+    thread->shareStart = -1;
+    competingTickets -= thread->tickets;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -177,43 +566,328 @@ Scheduler::Print()
 {
     printf("=======================Scheduler Queue=========================\n");
     printf("Ready list contents: ");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
-    printf("\nWaiting list contents: ");
-    waitingList->Mapcar((VoidFunctionPtr) ThreadPrint);
-    printf("\nTerminated list contents: ");
-    terminatedList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    readyList[0]->Print();
+#ifdef USER_PROGRAM
+    for (int i = 1; i < numCPUs; i++) {
+        printf("\nReady list contents (CPU %d): ", i);
+        readyList[i]->Print();
+    }
+    printf("\nProcesses: ");
+    for (int i = 0; i < MaxUserProcess; i++)
+        if (processes[i] != NULL)
+            printf("%d %s%s, ", i + 100, processes[i]->getName(),
+                (processes[i]->status == TERMINATED) ? " (terminated)" : "");
+#endif
     printf("\n=============================================================\n\n\n");
 }
 
 
 #ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// Scheduler::Resume
+// 	线程重新被调度到某个CPU上后(Run或ParkCPU中SWITCH返回后)调用:
+//	把它的用户态寄存器和页表装入这个CPU, 即machine; 它们还留在machine
+//	中(见Run中的userThread)时就不用再装了.
+//----------------------------------------------------------------------
+
 void
-Scheduler::removeFromTerminatedList(int pid) {
-    ListElement *cur = terminatedList->getFirst();
-    while(cur != NULL){
-        Thread *thread = (Thread *)cur->item;
-        if(thread->getPid() == pid){
-            terminatedList->RemoveByItem(cur->item);
-            delete thread;
-            thread = NULL;
-            break;
+Scheduler::Resume()
+{
+    if (currentThread->pcb->space != NULL) {		// if there is an address space
+        if (userThread == currentThread)            // 寄存器和页表还在machine中
+            userThread = NULL;
+        else {
+            currentThread->pcb->RestoreUserState(); // to restore, do it.
+	        currentThread->pcb->space->RestoreState();
+            DEBUG('t', "Restore user program state.\n");
+        }
+        if (DebugIsEnabled('s')) {
+            currentThread->pcb->space->Print();
+            machine->DumpState();
         }
-        cur = cur->next;
     }
+    if (DebugIsEnabled('t'))
+        Print();
 }
 
+//----------------------------------------------------------------------
+// Scheduler::StartCPUs
+// 	Initialize时调用: 主线程在CPU 0上运行, 其余CPU都空闲.
+//----------------------------------------------------------------------
+
 void
-Scheduler::emptyList(List *list) {
-    while (list->Remove() != NULL);	 // delete all the list elements
+Scheduler::StartCPUs()
+{
+    onCPU[0] = currentThread;
+    currentThread->lastCPU = 0;
 }
 
-List *
-Scheduler::getTerminatedList() const {
-    return this->terminatedList;
+//----------------------------------------------------------------------
+// Scheduler::ChooseCPU
+// 	线程就绪时, 选择放入哪个CPU的就绪队列: 运行过的线程回到上次运行
+//	它的CPU; 新线程交给一个空闲的CPU, 没有空闲的CPU就留在本CPU上.
+//----------------------------------------------------------------------
+
+int
+Scheduler::ChooseCPU(Thread *thread)
+{
+    if (thread->lastCPU >= 0)
+        return thread->lastCPU;
+    for (int i = 0; i < numCPUs; i++)
+        if (onCPU[i] == NULL && readyList[i]->IsEmpty())
+            return i;
+    return cpu;
 }
 
-List *
-Scheduler::getWaitingList() const {
-    return this->waitingList;
+//----------------------------------------------------------------------
+// Scheduler::FindNextToRun
+// 	为CPU which找下一个要运行的线程: 先取它自己的就绪队列,
+//	为空时依次从其他CPU的就绪队列中取.  没有就绪线程时返回NULL.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::FindNextToRun(int which)
+{
+    Thread *thread = readyList[which]->Remove();
+
+    for (int i = 1; thread == NULL && i < numCPUs; i++)
+        thread = readyList[(which + i) % numCPUs]->Remove();
+    return thread;
 }
-#endif
\ No newline at end of file
+
+//----------------------------------------------------------------------
+// CPUSliceHandler, SwitchToNextCPU
+//	时间片中断的处理函数, 及其要求中断返回后调用的函数.
+//----------------------------------------------------------------------
+
+static void CPUSliceHandler(_int dummy) { scheduler->EndSlice(); }
+static void SwitchToNextCPU()           { scheduler->NextCPU(); }
+
+//----------------------------------------------------------------------
+// Scheduler::StartSlice
+// 	安排一个时间片中断, 在ticks之后结束当前CPU的时间片.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartSlice(int ticks)
+{
+    sliceEnd = stats->totalTicks + ticks;
+    slicing = TRUE;
+    interrupt->Schedule(CPUSliceHandler, 0, ticks, TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndSlice
+// 	时间片中断: 中断返回后, 由被中断的线程调用NextCPU换到下一个CPU.
+//	中断可能是为一个已经提前结束的时间片(见ParkCPU)安排的, 这时
+//	只需为当前的时间片重新安排.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndSlice()
+{
+    slicing = FALSE;
+    if (onCPU[cpu] == NULL)                     // 所有CPU都空闲(见ParkCPU)
+        return;
+    if (stats->totalTicks < sliceEnd)
+        StartSlice(sliceEnd - stats->totalTicks);
+    else
+        interrupt->SwitchOnReturn(SwitchToNextCPU);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextCPU
+// 	当前CPU的时间片用完, 宿主机交给下一个忙碌的CPU; 本线程仍在
+//	这个CPU上, 轮到它时从这里返回.
+//
+//	像Thread::Yield一样关中断, 所以每次轮换(被切换到的CPU开中断时)
+//	要花一次开中断的时间, 相当于该CPU处理了一次时钟中断.
+//----------------------------------------------------------------------
+
+void
+Scheduler::NextCPU()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int next;
+
+    (void) Charge();                            // NextBusyCPU会把时间拨回本轮开始时
+    next = NextBusyCPU();
+
+    if (next != cpu) {
+        SwitchCPU(next);
+        if (currentThread->pcb->space != NULL)
+            stats->SetProcess(currentThread->getPid());  // 此后的TLB命中/缺失计入本进程
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ParkCPU
+// 	当前线程阻塞或结束, 而本CPU没有就绪线程可运行时调用(中断已关闭).
+//	如果别的CPU还忙, 本CPU就空闲下来, 宿主机交给下一个忙碌的CPU;
+//	线程被唤醒并重新调度到某个CPU上后, 返回TRUE.
+//	所有CPU都空闲时返回FALSE, 由调用者等待中断(Interrupt::Idle).
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ParkCPU()
+{
+    int next;
+
+    if (numCPUs == 1)
+        return FALSE;
+    (void) Charge();
+    onCPU[cpu] = NULL;
+    next = NextBusyCPU();
+    if (next < 0)
+        return FALSE;
+    if (currentThread->pcb->space != NULL) {    // 线程离开本CPU, 保存其用户态
+        currentThread->pcb->SaveUserState();
+        currentThread->pcb->space->SaveState();
+    }
+    SwitchCPU(next);
+    Resume();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextBusyCPU
+// 	找出下一个轮到的忙碌CPU, 并把模拟时间设为它的时间片开始的时刻.
+//	一轮中, 各个忙碌的CPU按编号依次运行一个时间片, 都从本轮开始的
+//	时刻算起(它们是同时运行的); 一轮结束后, 新的一轮从各CPU到达的
+//	最晚时刻开始, 空闲的CPU先领取就绪线程.
+//
+//	返回该CPU的编号; 所有CPU都空闲时返回-1.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NextBusyCPU()
+{
+    Thread *thread;
+    int next = -1, busy = 0;
+    int i;
+
+    if (stats->totalTicks > roundEnd)
+        roundEnd = stats->totalTicks;
+    for (i = cpu + 1; i < numCPUs && next < 0; i++)
+        if (onCPU[i] != NULL)
+            next = i;
+    if (next < 0) {                             // 本轮结束, 开始新的一轮
+        roundStart = roundEnd;
+        for (i = 0; i < numCPUs; i++)
+            if (onCPU[i] == NULL && (thread = FindNextToRun(i)) != NULL) {
+                thread->setStatus(RUNNING);     // 轮到CPU i时开始运行
+                thread->lastCPU = i;
+                Dispatch(thread, roundStart);
+                onCPU[i] = thread;
+            }
+        for (i = 0; i < numCPUs && next < 0; i++)
+            if (onCPU[i] != NULL)
+                next = i;
+    }
+    stats->totalTicks = roundStart;
+
+    for (i = 0; i < numCPUs; i++)
+        if (onCPU[i] != NULL)
+            busy++;
+    sliceEnd = roundStart + CPUSlice;
+    if (busy > 1 && !slicing)
+        StartSlice(CPUSlice);
+    return next;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCPU
+// 	宿主机交给CPU which, 运行它上面的线程: 该线程或者在其CPU的时间片
+//	用完时停在NextCPU中, 或者是刚分给这个空闲CPU的就绪线程.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCPU(int which)
+{
+    Thread *oldThread = currentThread;
+    int oldCPU = cpu;
+
+    oldThread->CheckOverflow();
+    cpu = which;
+    machine = cpus[which];
+    stats->SetCPU(which);
+    currentThread = onCPU[which];
+    chargeStart = stats->totalTicks;            // 从本CPU的时间片开始时计时
+    chargeIdle = stats->idleTicks;
+
+    DEBUG('t', "Switching from CPU %d (thread \"%s\") to CPU %d (thread \"%s\").\n",
+        oldCPU, oldThread->getName(), which, currentThread->getName());
+    SWITCH(oldThread, currentThread);
+    DEBUG('t', "Now in thread \"%s\"\n", currentThread->getName());
+
+    if (threadToBeDestroyed != NULL) {
+        delete threadToBeDestroyed;
+	    threadToBeDestroyed = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AddProcess
+// 	在进程表中登记用户进程thread: Exec创建时, 以及结束后没有Joiner
+//	在等待、要留作僵尸时(-x启动的进程只在这时登记).
+//----------------------------------------------------------------------
+
+void
+Scheduler::AddProcess(Thread *thread)
+{
+    int slot = thread->getPid() - 100;          // 0~99保留给核心进程
+
+    ASSERT(slot >= 0 && slot < MaxUserProcess);
+    ASSERT(processes[slot] == NULL || processes[slot] == thread);
+    processes[slot] = thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::FindProcess
+// 	返回进程表中pid号的进程(可能已经结束), 没有时返回NULL.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::FindProcess(int pid)
+{
+    if (pid < 100 || pid >= 100 + MaxUserProcess)
+        return NULL;
+    return processes[pid - 100];
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveProcess
+// 	从进程表中去掉thread, 在它被删除(因而释放pid)之前调用.
+//----------------------------------------------------------------------
+
+void
+Scheduler::RemoveProcess(Thread *thread)
+{
+    int slot = thread->getPid() - 100;
+
+    if (slot >= 0 && slot < MaxUserProcess && processes[slot] == thread)
+        processes[slot] = NULL;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ReapChildren
+// 	-x启动的进程退出时调用: 回收它的已经结束而没有被Join的子进程,
+//	它们不会再被Join了.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ReapChildren(int pid)
+{
+    Thread *thread;
+
+    for (int i = 0; i < MaxUserProcess; i++) {
+        thread = processes[i];
+        if (thread != NULL && thread->status == TERMINATED
+                        && thread->pcb->parentPid == pid) {
+            processes[i] = NULL;
+            delete thread;
+        }
+    }
+}
+#endif
@@ -1,6 +1,7 @@
 // scheduler.h 
 //	Data structures for the thread dispatcher and scheduler.
-//	Primarily, the list of threads that are ready to run.
+//	Primarily, the list of threads that are ready to run, kept
+//	by priority, or by pass (see readyqueue.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -12,34 +13,124 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "readyqueue.h"
+#include "stats.h"
+
+// The scheduling policies, chosen with -sched
+enum SchedPolicy { PrioritySched,	// fixed priorities (the default)
+		   MLFQSched,		// multilevel feedback queue
+		   StrideSched };	// stride scheduling
+
+// Under the multilevel feedback queue, priorities 0 (where threads
+// start) to MLFQLevels - 1 are the levels of the queue.  A thread that
+// has run for the quantum of its level, whether in one go or a bit at a
+// time, moves down a level; every MLFQBoostTicks, every thread moves
+// back up to the top.  The timer is checked every TimerTicks.
+#define MLFQLevels		4
+#define MLFQQuantum(level)	((2 * TimerTicks) << (level))
+#define MLFQBoostTicks		50000
+
+// Under stride scheduling, each thread gets a share of the CPU in
+// proportion to its tickets (see DefaultTickets in thread.h).  Running
+// for a tick adds StrideLarge / tickets to its pass, and the ready
+// thread with the smallest pass runs next; a thread that has been
+// away starts again at the pass of the last thread to run, so that
+// it cannot save up time.  Priorities are ignored.  (With more than
+// one CPU, a thread can't use more than one of them, so the shares the
+// tickets ask for are only met when there are enough threads.)
+#define StrideLarge		(1 << 20)
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
 
+// 多处理机(-cpus)时, 各个CPU轮流占用宿主机, 每次运行一个时间片: 
+// 每一轮中, 各忙碌的CPU都从本轮开始的时刻起运行CPUSlice, 模拟的时间
+// 每轮只前进一个时间片, 所以它们是同时运行的.  每次轮换要花一次
+// 开中断的时间(SystemTick), 时间片相比之下要足够长.
+#define CPUSlice	1000	// 每个CPU每次运行的时间
+
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedPolicy how = PrioritySched);
+					// Initialize list of ready threads 
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
-    Thread* FindNextToRun();		// Dequeue first thread on the ready 
-					// list, if any, and return thread.
+    Thread* FindNextToRun();		// Dequeue first thread of the highest
+					// priority on the ready list, if any,
+					// and return thread.
+    bool ShouldYield();			// Is a thread as important as the
+					// running one ready?
+    bool RemoveReady(Thread* thread);	// Take thread off the ready list
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+
+    SchedPolicy getPolicy() { return policy; }
+    bool TimerTick();			// Charge the running thread at a
+					// timer interrupt; TRUE if it should
+					// give up the CPU
+    void Finished(Thread* thread);	// Count the times of a thread that
+					// is finishing
+    void Blocked(Thread* thread);	// Charge a thread that is going
+					// to sleep
+    void SetTickets(Thread* thread, int tickets);
+					// Change the tickets of a thread
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+    ReadyQueue *readyList[MaxCPUs];	// queue of threads that are ready to run,
+				// but not running, for each CPU
+    SchedPolicy policy;		// how to choose the next thread
+    int chargeStart;		// when the running thread was last charged
+    int chargeIdle;		// the idle time then
+    int boosts;			// # of times every thread has moved up
+    int nextBoost;		// when they will next move up
+    long long globalPass;	// the pass of the last thread to run
+    double virtualTime;		// ticks run per ticket competing
+    int competingTickets;	// tickets of the threads ready or running
+
+    bool Charge();		// Charge the running thread for its time;
+				// TRUE if its quantum is up
+    void Refresh(Thread* thread);	// Put thread back at the top, if
+				// there was a boost since it was placed
+    void Boost();		// Move every thread back up to the top
+    bool Before(Thread* a, Thread* b);	// Should a run before b?
+    void StartShare(Thread* thread);	// Thread starts/stops competing
+    void EndShare(Thread* thread);	// for the CPU
+    void Dispatch(Thread* thread, int when);
+				// Count the wait of a thread about to run
 #ifdef USER_PROGRAM
-    List *waitingList;    // Join产生的陷入阻塞的线程队列
-    List *terminatedList; // Join等操作产生的执行结束的线程队列
+public:
+    void StartCPUs();                         // 主线程在CPU 0上运行, 其余CPU空闲
+    bool ParkCPU();                           // 本CPU没有线程可运行: 让别的CPU运行, 线程被唤醒后返回TRUE
+    void EndSlice();                          // 时间片中断: 本CPU的时间片到了
+    void NextCPU();                           // 轮到下一个忙碌的CPU运行
+
+private:
+    Thread *onCPU[MaxCPUs]; // 各CPU上运行的线程, NULL表示该CPU空闲
+    int cpu;                // 占用宿主机的CPU, 即machine
+    int roundStart;         // 本轮开始的时刻
+    int roundEnd;           // 本轮中已运行的CPU到达的最晚时刻
+    int sliceEnd;           // 当前CPU的时间片结束的时刻
+    bool slicing;           // 是否已安排了时间片中断
+    Thread *userThread;     // 用户态寄存器还留在machine中、没有保存的线程
+                            // (只在单CPU时), 见Run
+
+    int ChooseCPU(Thread *thread);            // 线程就绪时放入哪个CPU的就绪队列
+    Thread *FindNextToRun(int which);         // 为CPU which找下一个线程, 必要时从其他CPU的队列中取
+    int NextBusyCPU();                        // 找下一个忙碌的CPU, 一轮结束时开始新的一轮
+    void StartSlice(int ticks);               // 安排ticks之后的时间片中断
+    void SwitchCPU(int which);                // 宿主机交给CPU which
+    void Resume();                            // 线程重新被调度后恢复其用户态
+
+    Thread *processes[MaxUserProcess];    // 进程表, 以pid - 100为下标: 运行中的进程, 
+                                          // 和已结束而还没有被Join回收的(僵尸)
 
 public:
-    void removeFromTerminatedList(int pid);   // 从terminatedList中删除线程pid
-    void emptyList(List *list);               // 清空队列
-    List *getTerminatedList() const;
-    List *getWaitingList() const;
+    void AddProcess(Thread *thread);          // 在进程表中登记thread(按其pid)
+    Thread *FindProcess(int pid);             // 进程表中的进程pid, 没有时返回NULL
+    void RemoveProcess(Thread *thread);       // 从进程表中去掉thread
+    void ReapChildren(int pid);               // 回收进程pid的所有僵尸子进程
 #endif
 };
 
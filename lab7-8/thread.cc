@@ -38,8 +38,19 @@ Thread::Thread(char* threadName) {
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    priority = DefaultPriority;
+    ticksUsed = quantumUsed = waitTicks = dispatches = 0;
+    boostEpoch = firstReady = responseTicks = -1;
+    tickets = DefaultTickets;
+    pass = 0;
+    shareStart = -1;
+    entitledTicks = 0;
+    readySince = 0;
+    schedId = -1;
+    traceId = -1;
 #ifdef USER_PROGRAM
     pcb = new PCB();
+    lastCPU = -1;
 #endif
 }
 
@@ -67,6 +78,43 @@ Thread::~Thread() {
 #endif
 }
 
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	删除的Thread对象挂在空闲链表上(用对象的第一个字做链接), new时
+//	优先从中取出重用; 和线程栈池(AllocBoundedArray)一起, 使反复的
+//	Fork/Finish在稳定后不再向堆或UNIX申请空间.
+//	和线程栈池一样, 链表上至多留MaxPooledObjects个对象, 再多的还给堆,
+//	以免一时有大量线程结束后空间一直被占着.
+//----------------------------------------------------------------------
+
+#define MaxPooledObjects 64             // 每个空闲链表上至多留这么多对象
+
+static void *freeThreads = NULL;        // 已删除的Thread对象
+static int numFreeThreads = 0;          // freeThreads上的对象数
+
+void *
+Thread::operator new(size_t size) {
+    void *p = freeThreads;
+
+    ASSERT(size == sizeof(Thread));
+    if (p == NULL)
+        return ::operator new(size);
+    freeThreads = *(void **) p;
+    numFreeThreads--;
+    return p;
+}
+
+void
+Thread::operator delete(void *p) {
+    if (numFreeThreads == MaxPooledObjects) {
+        ::operator delete(p);
+        return;
+    }
+    *(void **) p = freeThreads;
+    freeThreads = p;
+    numFreeThreads++;
+}
+
 //----------------------------------------------------------------------
 // Thread::Fork
 // 	Invoke (*func)(arg), allowing caller and callee to execute 
@@ -89,7 +137,7 @@ Thread::~Thread() {
 
 void 
 Thread::Fork(VoidFunctionPtr func, _int arg) {
-#ifdef HOST_ALPHA
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
     DEBUG('t', "Forking thread \"%s\" with func = 0x%lx, arg = %ld\n",
 	  name, (long) func, arg);
 #else
@@ -150,20 +198,22 @@ void
 Thread::Finish () {
     (void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
+    scheduler->Finished(this);          // 计入调度统计
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "finish", NULL, 0);
 #ifdef USER_PROGRAM
-    // step 1: 获取waitingList
-    List *waitingList = scheduler->getWaitingList();
-    // step 2: 
-    // 在waitingList中找到Joiner
-    // 将其从队列移除, 调度运行Joiner
-    Thread *thread = FindThread(waitingList, pcb->parentPid);
-    if (thread) {
+    // step 1: 
+    // 唤醒本进程等待队列中的所有Joiner, 交给它们退出码
+    // 多处理机上子进程不一定按创建的顺序结束, 所以每个进程有自己的等待队列
+    Thread *thread;
+    bool joined = FALSE;
+    while ((thread = pcb->joiners.Remove()) != NULL) {
         thread->pcb->waitProcessExitCode = this->pcb->exitCode;
         scheduler->ReadyToRun(thread);
-        waitingList->RemoveByItem(thread);
+        joined = TRUE;
     }
-    // step 3：完成Joinee的终止收尾工作
-    Terminated();
+    // step 2：完成Joinee的终止收尾工作
+    Terminated(joined);
 #else
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
     threadToBeDestroyed = currentThread;
@@ -174,11 +224,12 @@ Thread::Finish () {
 
 //----------------------------------------------------------------------
 // Thread::Yield
-// 	Relinquish the CPU if any other thread is ready to run.
-//	If so, put the thread on the end of the ready list, so that
-//	it will eventually be re-scheduled.
+// 	Relinquish the CPU if any other thread of the same or a higher
+//	priority (under stride scheduling, with no larger a pass) is ready
+//	to run.  If so, put the thread on the end of the ready list for
+//	its priority, so that it will eventually be re-scheduled.
 //
-//	NOTE: returns immediately if no other thread on the ready queue.
+//	NOTE: returns immediately if no such thread is on the ready queue.
 //	Otherwise returns when the thread eventually works its way
 //	to the front of the ready list and gets re-scheduled.
 //
@@ -199,7 +250,15 @@ Thread::Yield () {
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     
-    nextThread = scheduler->FindNextToRun();
+    if (scheduler->ShouldYield())
+	nextThread = scheduler->FindNextToRun();
+    else
+	nextThread = NULL;		// only less important threads are ready
+    if (schedStats != NULL)
+	schedStats->Yielded(this, nextThread != NULL);
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "yield",
+			"switched", nextThread != NULL);
     if (nextThread != NULL) {
 	scheduler->ReadyToRun(this);
 	scheduler->Run(nextThread);
@@ -207,6 +266,29 @@ Thread::Yield () {
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	改变线程的优先级.  就绪的线程从原优先级的队列中取出, 放到新优先级
+//	队列的末尾; 若它因此比当前线程更重要, 由Scheduler::ReadyToRun
+//	安排抢占.  当前线程降低自己的优先级后不会自动让出CPU, 需要时
+//	由调用者Yield.
+//
+//	"newPriority" -- 0(最高)到NumPriorities - 1(最低)
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int newPriority) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(newPriority >= 0 && newPriority < NumPriorities);
+    if (status == READY && scheduler->RemoveReady(this)) {
+        priority = newPriority;
+        scheduler->ReadyToRun(this);
+    } else
+        priority = newPriority;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 // 	Relinquish the CPU, because the current thread is blocked
@@ -236,12 +318,37 @@ Thread::Sleep () {
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
-    while ((nextThread = scheduler->FindNextToRun()) == NULL)
+    scheduler->Blocked(this);
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "sleep", NULL, 0);
+    while ((nextThread = scheduler->FindNextToRun()) == NULL) {
+#ifdef USER_PROGRAM
+        if (scheduler->ParkCPU())   // 其他CPU还在运行: 本CPU空闲, 被唤醒后返回
+            return;
+#endif
 	    interrupt->Idle();	// no one to run, wait for an interrupt
+    }
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepUntil
+// 	Relinquish the CPU until the time (stats->totalTicks) is "when",
+//	instead of yielding again and again until then.  The thread waits
+//	in the alarm clock, which wakes it up with an interrupt (see
+//	alarm.h).  Returns at once if the time has come already.
+//
+//	"when" is the time to wake up at.
+//----------------------------------------------------------------------
+
+void
+Thread::SleepUntil(int when)
+{
+    ASSERT(this == currentThread);
+    alarmClock->WaitUntil(when);
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -251,13 +358,24 @@ Thread::Sleep () {
 //----------------------------------------------------------------------
 
 static void ThreadFinish()    { currentThread->Finish(); }
-static void InterruptEnable() { interrupt->Enable(); }
+static void InterruptEnable() {
+#ifdef USER_PROGRAM
+    // 用户进程第一次运行: 开中断时就可能被抢占, 所以先把它的寄存器和页表
+    // 装入machine, 否则Run会把machine中上一个进程的页表当作它的保存下来
+    if (currentThread->pcb->space != NULL) {
+        currentThread->pcb->space->InitRegisters();
+        currentThread->pcb->space->RestoreState();
+    }
+#endif
+    interrupt->Enable();
+}
 void ThreadPrint(_int arg){ Thread *t = (Thread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
 //	Allocate and initialize an execution stack.  The stack is
 //	initialized with an initial stack frame for ThreadRoot, which:
+//		loads a user program's registers and page table, if any
 //		enables interrupts
 //		calls (*func)(arg)
 //		calls Thread::Finish
@@ -279,8 +397,17 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg) {
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
     stackTop = stack + StackSize - 96;
-#else  // HOST_MIPS  || HOST_i386 || HOST_ALPHA
+#else  // HOST_MIPS  || HOST_i386 || HOST_ALPHA || HOST_x86_64
     stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+#ifdef HOST_x86_64
+    // SWITCH for x86-64 leaves the return address on the stack instead
+    // of saving it in machineState[PCState], so the thread's first
+    // return, to ThreadRoot, is put on its stack here.  stackTop is
+    // 16-byte aligned, so ThreadRoot starts with the stack aligned as
+    // the calls it makes need.
+    stackTop -= sizeof(_int) / sizeof(int);
+    *(_int *) stackTop = (_int) ThreadRoot;
+#endif
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -374,6 +501,37 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg) {
 #ifdef USER_PROGRAM
 #include "machine.h"
 
+//----------------------------------------------------------------------
+// PCB::operator new, PCB::operator delete
+// 	同Thread, 删除的PCB对象留在空闲链表上重用, 至多MaxPooledObjects个.
+//----------------------------------------------------------------------
+
+static void *freePCBs = NULL;           // 已删除的PCB对象
+static int numFreePCBs = 0;             // freePCBs上的对象数
+
+void *
+PCB::operator new(size_t size) {
+    void *p = freePCBs;
+
+    ASSERT(size == sizeof(PCB));
+    if (p == NULL)
+        return ::operator new(size);
+    freePCBs = *(void **) p;
+    numFreePCBs--;
+    return p;
+}
+
+void
+PCB::operator delete(void *p) {
+    if (numFreePCBs == MaxPooledObjects) {
+        ::operator delete(p);
+        return;
+    }
+    *(void **) p = freePCBs;
+    freePCBs = p;
+    numFreePCBs++;
+}
+
 //----------------------------------------------------------------------
 // PCB::SaveUserState
 //	Save the CPU state of a user program on a context switch.
@@ -383,7 +541,7 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg) {
 //	while executing kernel code.  This routine saves the former.
 //----------------------------------------------------------------------
 
-PCB::PCB() {
+PCB::PCB() : joiners(&Thread::queueLink) {
     for (int i = 0; i < NumTotalRegs; i++)
         userRegisters[i] = 0;
     parentPid = 0;
@@ -468,47 +626,76 @@ PCB::RestoreUserState() {
 	    machine->WriteRegister(i, userRegisters[i]);
 }
 
+//----------------------------------------------------------------------
+// Thread::Join
+// 	系统调用Join: 等待进程pid结束, 取得其退出码(放在
+//	pcb->waitProcessExitCode中; 没有这个进程时为-1).
+//
+//	进程在进程表(见Scheduler::FindProcess)中按pid直接找到, 每个进程
+//	有自己的Joiner等待队列, 所以Join, 结束和回收都不用查找线程队列.
+//	已结束的进程留在进程表中(僵尸), 直到被Join时回收; 结束时已经有
+//	Joiner在等待的进程则不留下, 见Terminated.
+//----------------------------------------------------------------------
+
 void
 Thread::Join(int pid) {
     DEBUG('t', "Thread::Join: Now in thread \"%s\"\n", currentThread->getName());
     IntStatus oldLevel = interrupt->SetLevel(IntOff);       // 关中断
-    // step 1: 记录Joinee的pid
-    currentThread->pcb->waitProcessPid = pid;
-    List *terminatedList = scheduler->getTerminatedList();
-    List *waitingList = scheduler->getWaitingList();
-    // step 2: 在terminatedList中查找Joinee, 看是否运行结束
-    Thread *thread = FindThread(terminatedList, pid);
+    // step 1: 记录Joinee的pid, 在进程表中找到Joinee
+    pcb->waitProcessPid = pid;
+    Thread *thread = scheduler->FindProcess(pid);
 
     if (thread == NULL) {
+        // 没有这个进程, 或者它已经被回收
+        pcb->waitProcessExitCode = -1;
+    } else if (thread->status == TERMINATED) {
+        // step 2: Joinee已经结束, 获取Joinee的退出码, 回收Joinee
+        pcb->waitProcessExitCode = thread->pcb->exitCode;
+        scheduler->RemoveProcess(thread);
+        delete thread;
+    } else {
         // step 3: 
-        // Joinee不位于terminatedList, 说明Joinee正处于Ready/Blocked状态
-        // 将Joiner加入Waiting队列, 睡眠阻塞Joiner, 引发调度, 调度Joinee运行
-        waitingList->Append((void *)this);
-        currentThread->Sleep();
-        thread = FindThread(terminatedList, pid);       // 此处thread还是NULL呢!!!!!!
+        // Joinee正处于Ready/Blocked状态
+        // 将Joiner加入Joinee的等待队列, 睡眠阻塞Joiner, 引发调度;
+        // Joinee结束时(Finish)设置退出码并唤醒Joiner, 并且不留作僵尸
+        thread->pcb->joiners.Append(this);
+        Sleep();
     }
-    // step 4: Joinee执行结束, 获取Joinee的退出码, 在terminatedList中回收Joinee, 继续运行Joiner
-    currentThread->pcb->waitProcessExitCode = thread->pcb->exitCode;
-    scheduler->removeFromTerminatedList(pid);
-    interrupt->SetLevel(IntOn);         // 开中断
+    (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::Terminated
+// 	线程终止的收尾工作, 由Finish在唤醒Joiner之后调用, 不再返回.
+//	已经有Joiner在等待的线程交给下一个线程删除(threadToBeDestroyed),
+//	并离开进程表; 否则作为僵尸留在进程表中, 等待Join回收.
+//
+//	"joined" -- Finish是否唤醒了Joiner
+//----------------------------------------------------------------------
+
 void
-Thread::Terminated() {
+Thread::Terminated(bool joined) {
     // step 1: 检查是否有错误
     ASSERT(this == currentThread);
     ASSERT(interrupt->GetLevel() == IntOff);
     DEBUG('t', "Terminated: Now in thread \"%s\"\n", currentThread->getName());
-    // step 2: 当前线程状态为TERMINATED, 并将其放入terminatedList
+    // step 2: 当前线程状态为TERMINATED, 留在进程表中, 或者交给下一个线程删除
     this->status = TERMINATED;
-    List *terminatedList = scheduler->getTerminatedList();
-    terminatedList->Append((void *)this);
+    if (pcb->space == NULL)                 // 内核线程不在进程表中, 也不会被Join
+        threadToBeDestroyed = this;
+    else if (joined) {
+        scheduler->RemoveProcess(this);
+        threadToBeDestroyed = this;
+    } else
+        scheduler->AddProcess(this);
     // step 3: 从就绪队列寻找下一个线程执行
     // 此处的nextThread一定为currentThread->parentThread, 因为此时关中断, 不会有其他线程调度的影响
     // 换句话说Join过程是原子操作
     Thread *nextThread;
-    while ((nextThread = scheduler->FindNextToRun()) == NULL)
-        interrupt->Idle();
+    while ((nextThread = scheduler->FindNextToRun()) == NULL) {
+        if (!scheduler->ParkCPU())          // 其他CPU还在运行时, 本CPU空闲下来, 本线程不会再被调度
+            interrupt->Idle();
+    }
 
     scheduler->Run(nextThread);
     DEBUG('t', "Terminated complete.\n");       // 位于Run函数后面的指令都不会运行, 因为切换上下文了
@@ -518,18 +705,5 @@ int
 Thread::getPid() const {
     return pcb->space->getPid();
 }
- 
-Thread *
-Thread::FindThread(List *list, int pid) {
-    ListElement *element = list->getFirst();
-    Thread *thread = NULL;
-    while (element != NULL) {
-        thread = (Thread *) element->item;
-        if (thread == NULL || thread->getPid() == pid)
-            break;
-        element = element->next;
-    }
-    return thread;
-}
 
 #endif
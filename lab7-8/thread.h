@@ -39,6 +39,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "dlist.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -58,6 +59,16 @@
 #define StackSize	(sizeof(_int) * 1024)	// in words
 
 
+// 线程的优先级: 0最高, NumPriorities - 1最低; 就绪队列中每个优先级
+// 有一个队列(见readyqueue.h), 所以NumPriorities不能超过一个字的位数
+#define NumPriorities	32
+#define DefaultPriority	16	// 新线程的优先级
+
+// stride调度(-sched stride)时, 线程按彩票数的比例分得CPU
+#define DefaultTickets	100	// 新线程(及Exec的进程)的彩票数
+#define MaxTickets	10000
+
+
 // Thread state, 增加TERMINATED状态, 用于多线程机制
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, TERMINATED };
 
@@ -85,9 +96,12 @@ struct PCB {
     int waitProcessPid;               // 当前thread等待线程的pid
     int exitCode;                     // 当前thread的exitCode
     AddrSpace *space;			            // 用户线程的地址空间
+    DList<Thread> joiners;            // Join本进程而阻塞的线程(用Thread::queueLink链接)
 
     PCB();                            // 构造函数
     ~PCB();                           // 析构函数
+    void *operator new(size_t size);  // 重用已删除的PCB的空间
+    void operator delete(void *p);    // 删除后留待重用(有上限)
     void SaveUserState();		          // 保存用户寄存器内容
     void RestoreUserState();		      // 恢复用户寄存器
 #ifdef FILESYS
@@ -99,6 +113,9 @@ struct PCB {
 };
 #endif
 
+// NOTE: 本文件和threads/thread.h中Thread的数据成员必须完全一致, 见那里的
+// 说明.  只在lab7-8中使用的成员(如lastCPU)在threads/thread.h中也要有.
+
 class Thread {
   private:
     // NOTE: DO NOT CHANGE the order of these first two members.
@@ -109,22 +126,51 @@ class Thread {
   public:
     Thread(char* debugName = "default");		// 初始化线程
     ~Thread(); 				          // 删除线程, 该线程必须是terminated状态
+    void *operator new(size_t size);  // 重用已删除的Thread的空间
+    void operator delete(void *p);    // 删除后留待重用(有上限)
 
     // basic thread operations
     void Fork(VoidFunctionPtr func, _int arg); 	// 线程从函数(*func)(arg)开始运行
     void Yield();  				      // 其他线程运行, 让出CPU运行权
     void Sleep();  				      // 线程睡眠, 让出CPU运行权
+    void SleepUntil(int when);			      // 睡眠到时刻when(stats->totalTicks)
     void Finish();  		        // 线程运行结束后调用Finish
     
     void CheckOverflow();       // 检查线程栈是否溢出
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
+    int getPriority() { return priority; }
+    void setPriority(int newPriority);  // 改变优先级, 线程就绪时移到相应的就绪队列
+    int getTickets() { return tickets; }
+    long long getPass() { return pass; }
     void Print() { printf("%s, ", name); }
 
+    DLink<Thread> queueLink;    // 在就绪队列或信号量/条件变量的等待队列中的链接,
+                                // 线程同时只能在其中一个队列中
+    int schedId;                // 在调度统计(-schedstats)中的编号, -1表示还没有
+    int traceId;                // 在内核事件跟踪(-trace)中的编号, -1表示还没有
+
   private:
     // some of the private data for this class is listed above
     int* stack; 	 		          // 栈底指针, 主线程栈底指针为NULL 
     ThreadStatus status;		    // 线程状态：ready, running, blocked or terminated
+    int priority;               // 优先级, 0最高
+
+    // 调度的记账(见Scheduler::Charge), 时间都以tick计
+    int ticksUsed;              // 运行的总时间, 不计空闲时间
+    int quantumUsed;            // MLFQ: 在当前级别已用的时间
+    int boostEpoch;             // MLFQ: 定级时是第几次提升, -1表示还没有定级
+    int readySince;             // 最近一次进入就绪队列的时刻
+    int waitTicks;              // 在就绪队列中等待的总时间
+    int firstReady;             // 第一次进入就绪队列的时刻, -1表示还没有
+    int responseTicks;          // 第一次就绪到第一次运行的时间, -1表示还没有运行过
+    int dispatches;             // 被调度运行的次数
+    int tickets;                // stride: 彩票数, 见Scheduler::SetTickets
+    long long pass;             // stride: 运行时间除以彩票数, 最小的先运行
+    double shareStart;          // stride: 开始竞争CPU(就绪或运行)时的虚拟时间, -1表示不在竞争
+    double entitledTicks;       // stride: 按彩票数应分得的运行时间
+    friend class Scheduler;
     char name[64];              // 线程debug名称
 
     void StackAllocate(VoidFunctionPtr func, _int arg);   // Fork内部调用, 分配线程的栈空间
@@ -136,13 +182,12 @@ class Thread {
 
   public:
     void Join(int pid);               // 系统调用Join: 阻塞当前线程, 执行pid线程, pid执行完毕后回收其资源, 重新运行当前线程
-    void Terminated();                // 线程终止收尾操作
+    void Terminated(bool joined);     // 线程终止收尾操作, joined: 已有线程Join本线程
     
     int getPid() const;               // 获取Pid
     PCB *pcb;                         // 用户进程的相关变量
   private:
-    Thread *FindThread(List *list, int pid);   // 从list中寻找线程号为pid的线程
-    friend class Scheduler;
+    int lastCPU;                      // 上次运行该线程的CPU, -1表示还没有运行过
 #endif
 };
 
@@ -93,11 +93,23 @@ Console::CheckCharAvail()
 			ConsoleReadInt);
 
     // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    if (incoming != EOF)
+	return;
+    if ((eventLog != NULL) && eventLog->IsReplaying()
+		&& (eventLog->NextEvent(ConsoleEvent) >= 0)) {
+	// take the characters from the log instead, at the logged times
+	if (eventLog->NextEvent(ConsoleEvent) > stats->totalTicks)
+	    return;
+	eventLog->Replay(ConsoleEvent, &c, sizeof(char));
+    } else {
+	if (!PollFile(readFileNo))
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (eventLog != NULL && eventLog->IsRecording())
+	    eventLog->Record(ConsoleEvent, stats->totalTicks, &c, sizeof(char));
+    }
+
+    // tell user about the character
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
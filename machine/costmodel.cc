@@ -0,0 +1,198 @@
+// costmodel.cc
+//	Routines to charge user instructions what they would cost on a
+//	pipelined MIPS, rather than a flat UserTick each (-cost).
+//
+//	Each kind of instruction (see InstrClass in stats.h) takes a
+//	given number of ticks: InstrTicks, which can be set from the
+//	command line.  On top of that, the pipeline stalls
+//
+//	   when an instruction uses the register loaded by the one just
+//	   before it (the load delay slot: the simulator gives it the old
+//	   value, as the R2000 does, but we charge as if the pipeline
+//	   waited, as later MIPS do), for LoadUseTicks;
+//
+//	   when MFHI or MFLO (or another MULT or DIV, or MTHI or MTLO)
+//	   comes before the MULT or DIV in progress has finished.  The
+//	   InstrTicks for a MULT or DIV are how long it takes to finish;
+//	   the instruction itself issues in UserTick, and the other
+//	   instructions run while it works.
+//
+//	The time is counted for each process (see Statistics::SetProcess),
+//	and printed with the other statistics when Nachos halts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "machine.h"
+#include "system.h"
+
+bool ModelCosts = FALSE;		// charge by the cost model? (-cost)
+int InstrTicks[NumInstrClasses] = {	// the defaults are in the range of
+    1,					// alu	  an R3000 with a slow memory
+    2,					// load
+    2,					// store
+    12,					// mult
+    35,					// div
+    2,					// branch
+    1					// syscall
+};
+int LoadUseTicks = 1;
+
+// names for the kinds of instructions, as given to -cost
+static const char *classNames[NumInstrClasses] =
+	{ "alu", "load", "store", "mult", "div", "branch", "syscall" };
+
+//----------------------------------------------------------------------
+// SetCosts
+// 	Turn on the cost model, and change the cost of some kinds of
+//	instructions from the defaults.
+//
+//	"spec" -- a list like "load=3,div=20,loaduse=2", naming any of the
+//		kinds of instructions, or "loaduse" for the load use stall;
+//		or NULL to keep the defaults
+//----------------------------------------------------------------------
+
+void
+SetCosts(char *spec)
+{
+    char name[20];
+    int ticks, length, i;
+
+    ModelCosts = TRUE;
+    while (spec != NULL && *spec != '\0') {
+	if (sscanf(spec, "%19[a-z]=%d%n", name, &ticks, &length) != 2
+				|| ticks < 0) {
+	    printf("Bad cost \"%s\"; should be like load=2,div=35\n", spec);
+	    Exit(1);
+	}
+	if (!strcmp(name, "loaduse"))
+	    LoadUseTicks = ticks;
+	else {
+	    for (i = 0; i < NumInstrClasses; i++)
+		if (!strcmp(name, classNames[i]))
+		    break;
+	    if ((i == NumInstrClasses) || (ticks < UserTick)) {
+		printf("Bad cost \"%s\"\n", spec);
+		Exit(1);
+	    }
+	    InstrTicks[i] = ticks;
+	}
+	spec += length;
+	if (*spec == ',')
+	    spec++;
+    }
+}
+
+//----------------------------------------------------------------------
+// ClassOf
+// 	Return the kind of instruction "opCode" is.
+//----------------------------------------------------------------------
+
+static InstrClass
+ClassOf(int opCode)
+{
+    switch (opCode) {
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR:
+	return LoadInstr;
+      case OP_SB: case OP_SH: case OP_SW: case OP_SWL: case OP_SWR:
+	return StoreInstr;
+      case OP_MULT: case OP_MULTU:
+	return MultInstr;
+      case OP_DIV: case OP_DIVU:
+	return DivInstr;
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return BranchInstr;
+      case OP_SYSCALL: case OP_UNIMP: case OP_RES:
+	return SyscallInstr;
+      default:
+	return ALUInstr;
+    }
+}
+
+//----------------------------------------------------------------------
+// ReadsRegister
+// 	Return TRUE if instruction "instr" reads general register "reg".
+//----------------------------------------------------------------------
+
+static bool
+ReadsRegister(Instruction *instr, int reg)
+{
+    switch (instr->opCode) {
+      case OP_J: case OP_JAL: case OP_LUI: case OP_MFHI: case OP_MFLO:
+      case OP_SYSCALL: case OP_UNIMP: case OP_RES:
+	return FALSE;				// no registers
+      case OP_ADDI: case OP_ADDIU: case OP_ANDI: case OP_ORI: case OP_XORI:
+      case OP_SLTI: case OP_SLTIU: case OP_LB: case OP_LBU: case OP_LH:
+      case OP_LHU: case OP_LW: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_JR: case OP_JALR:
+      case OP_MTHI: case OP_MTLO:
+	return instr->rs == reg;		// just rs
+      case OP_SLL: case OP_SRA: case OP_SRL:
+	return instr->rt == reg;		// just rt
+      default:
+	return (instr->rs == reg) || (instr->rt == reg);
+    }
+}
+
+//----------------------------------------------------------------------
+// UsesHiLo
+// 	Return TRUE if instruction "opCode" must wait for a MULT or DIV
+//	to finish.
+//----------------------------------------------------------------------
+
+static bool
+UsesHiLo(int opCode)
+{
+    switch (opCode) {
+      case OP_MFHI: case OP_MFLO: case OP_MTHI: case OP_MTLO:
+      case OP_MULT: case OP_MULTU: case OP_DIV: case OP_DIVU:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::ChargeCost
+// 	Charge the time instruction "instr", just fetched, takes under the
+//	cost model, beyond the UserTick that OneTick will charge once it
+//	has run.  Called by Machine::Execute, before the instruction is
+//	run, so that the delayed load of the one before is still pending.
+//----------------------------------------------------------------------
+
+void
+Machine::ChargeCost(Instruction *instr)
+{
+    InstrClass kind = ClassOf(instr->opCode);
+    ProcessCounters *counters = stats->process;
+    int ticks, stall = 0;
+
+    if ((registers[LoadReg] != 0) && ReadsRegister(instr, registers[LoadReg])) {
+	stall += LoadUseTicks;
+	counters->loadStallTicks += LoadUseTicks;
+    }
+    if (UsesHiLo(instr->opCode) && (hiloBusyTicks > 0)) {
+	stall += hiloBusyTicks;
+	counters->hiloStallTicks += hiloBusyTicks;
+	hiloBusyTicks = 0;
+    }
+    if ((kind == MultInstr) || (kind == DivInstr)) {
+	ticks = UserTick;			// it finishes in the background
+	hiloBusyTicks = InstrTicks[kind] - UserTick;
+    } else {
+	ticks = InstrTicks[kind];
+	hiloBusyTicks -= ticks + stall;
+	if (hiloBusyTicks < 0)
+	    hiloBusyTicks = 0;
+    }
+    counters->instructions[kind]++;
+    counters->ticks[kind] += ticks;
+
+    stats->totalTicks += ticks + stall - UserTick;
+    stats->userTicks += ticks + stall - UserTick;
+}
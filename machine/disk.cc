@@ -78,6 +78,65 @@ Disk::~Disk()
     Close(fileno);
 }
 
+//----------------------------------------------------------------------
+// Disk::Checkpoint
+// 	Write the contents of the disk to the open UNIX file "fd", for a
+//	checkpoint of the simulation.  No request may be in progress.
+//----------------------------------------------------------------------
+
+void
+Disk::Checkpoint(int fd)
+{
+    char *image = new char[DiskSize];
+
+    ASSERT(!active);
+    Lseek(fileno, 0, 0);
+    Read(fileno, image, DiskSize);
+    WriteFile(fd, image, DiskSize);
+    delete [] image;
+}
+
+//----------------------------------------------------------------------
+// Disk::Restore
+// 	Overwrite the disk with the contents saved by Checkpoint.
+//----------------------------------------------------------------------
+
+void
+Disk::Restore(int fd)
+{
+    char *image = new char[DiskSize];
+
+    ASSERT(!active);
+    Read(fd, image, DiskSize);
+    Lseek(fileno, 0, 0);
+    WriteFile(fileno, image, DiskSize);
+    delete [] image;
+}
+
+//----------------------------------------------------------------------
+// Disk::CheckpointHead, Disk::RestoreHead
+// 	Save where the head and the track buffer are, and put them back,
+//	so that later requests take as long as they would have.  This is
+//	kept apart from the contents, as whoever reads the restored disk
+//	moves the head.
+//----------------------------------------------------------------------
+
+void
+Disk::CheckpointHead(int fd)
+{
+    ASSERT(!active);
+    WriteFile(fd, (char *) &lastSector, sizeof(int));
+    WriteFile(fd, (char *) &bufferInit, sizeof(int));
+}
+
+void
+Disk::RestoreHead(int fd)
+{
+    ASSERT(!active);
+    Read(fd, (char *) &lastSector, sizeof(int));
+    Read(fd, (char *) &bufferInit, sizeof(int));
+}
+
 //----------------------------------------------------------------------
 // Disk::PrintSector()
 // 	Dump the data in a disk read/write request, for debugging.
@@ -129,6 +188,9 @@ Disk::ReadRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskReads++;
+    if (tracer != NULL)
+	tracer->Complete(TraceDisk, "disk", "read", ticks, "sector",
+			 sectorNumber);
     interrupt->Schedule(DiskDone, (_int) this, ticks, DiskInt);
 }
 
@@ -149,6 +211,9 @@ Disk::WriteRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskWrites++;
+    if (tracer != NULL)
+	tracer->Complete(TraceDisk, "disk", "write", ticks, "sector",
+			 sectorNumber);
     interrupt->Schedule(DiskDone, (_int) this, ticks, DiskInt);
 }
 
@@ -75,6 +75,11 @@ class Disk {
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
 
+    void Checkpoint(int fd);		// Save the contents of the disk
+    void Restore(int fd);		// to a UNIX file, and read them back
+    void CheckpointHead(int fd);	// Same for the position of the
+    void RestoreHead(int fd);		// head and the track buffer
+
   private:
     int fileno;				// UNIX file number for simulated disk 
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
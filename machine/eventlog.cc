@@ -0,0 +1,194 @@
+// eventlog.cc
+//	Routines to write a log of the events that come into Nachos from
+//	outside, and to read one back to play it again.
+//
+//	The log is a text file, with one line for each event:
+//
+//		<tick> <kind> <# of bytes> <the bytes, in hex, or "-">
+//
+//	in the order the events happened; so it can be looked at, and
+//	compared with another one, using the usual UNIX tools.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "eventlog.h"
+#include "system.h"
+
+// names for the kinds of events, as written in the log
+static const char *eventNames[NumEventTypes] =
+			{ "timer", "console", "stdin", "network" };
+
+//----------------------------------------------------------------------
+// LoggedEvent::LoggedEvent, LoggedEvent::~LoggedEvent
+// 	Keep a copy of an event read from the log, until it is replayed.
+//----------------------------------------------------------------------
+
+LoggedEvent::LoggedEvent(int time, char *contents, int size)
+{
+    when = time;
+    length = size;
+    used = 0;
+    data = NULL;
+    if (size > 0) {
+	data = new char[size];
+	bcopy(contents, data, size);
+    }
+}
+
+LoggedEvent::~LoggedEvent()
+{
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// EventLog::EventLog
+// 	Open a log of events.
+//
+//	"fileName" -- the UNIX file holding the log
+//	"replay" -- if TRUE, read all of the events out of an existing
+//		log, to be handed back as the devices ask for them;
+//		otherwise, create (or truncate) the file, for Record
+//----------------------------------------------------------------------
+
+EventLog::EventLog(char *fileName, bool replay)
+{
+    char name[20];
+    int when, length, type, i;
+    unsigned int byte;
+    char *data;
+
+    replaying = replay;
+    for (type = 0; type < NumEventTypes; type++)
+	pending[type] = new List("event log");
+
+    file = fopen(fileName, replay ? "r" : "w");
+    if (file == NULL) {
+	printf("Unable to open event log %s\n", fileName);
+	Exit(1);
+    }
+    if (!replay)
+	return;
+
+    while (fscanf(file, "%d %19s %d", &when, name, &length) == 3) {
+	for (type = 0; type < NumEventTypes; type++)
+	    if (!strcmp(name, eventNames[type]))
+		break;
+	ASSERT(type < NumEventTypes && length >= 0);
+	data = new char[length + 1];
+	if (length == 0)
+	    fscanf(file, " -");
+	for (i = 0; i < length; i++) {
+	    fscanf(file, "%2x", &byte);
+	    data[i] = (char) byte;
+	}
+	pending[type]->Append((void *) new LoggedEvent(when, data, length));
+	delete [] data;
+    }
+    fclose(file);
+    file = NULL;
+}
+
+//----------------------------------------------------------------------
+// EventLog::~EventLog
+// 	Finish writing the log, or, if it was being replayed, say how
+//	much of it was never asked for (the run was shorter than the one
+//	that made the log).
+//----------------------------------------------------------------------
+
+EventLog::~EventLog()
+{
+    int left = 0;
+    LoggedEvent *event;
+
+    if (file != NULL)
+	fclose(file);
+    for (int type = 0; type < NumEventTypes; type++) {
+	while ((event = (LoggedEvent *) pending[type]->Remove()) != NULL) {
+	    left++;
+	    delete event;
+	}
+	delete pending[type];
+    }
+    if (left > 0)
+	printf("Event log: %d events were not replayed\n", left);
+}
+
+//----------------------------------------------------------------------
+// EventLog::Record
+// 	Write an event to the log.
+//
+//	"type" -- what kind of event it is
+//	"when" -- the tick at which it happened
+//	"data", "length" -- what came into Nachos, if anything
+//----------------------------------------------------------------------
+
+void
+EventLog::Record(EventType type, int when, char *data, int length)
+{
+    ASSERT(!replaying);
+    fprintf(file, "%d %s %d ", when, eventNames[type], length);
+    if (length == 0)
+	fputc('-', file);
+    for (int i = 0; i < length; i++)
+	fprintf(file, "%02x", (unsigned char) data[i]);
+    fputc('\n', file);
+}
+
+//----------------------------------------------------------------------
+// EventLog::NextEvent
+// 	Return the tick at which the next event of kind "type" happened
+//	in the logged run, or -1 if there are none left.  The devices
+//	call this to see if it is time to deliver the event.
+//----------------------------------------------------------------------
+
+int
+EventLog::NextEvent(EventType type)
+{
+    ListElement *element = pending[type]->getFirst();
+
+    ASSERT(replaying);
+    if (element == NULL)
+	return -1;
+    return ((LoggedEvent *) element->item)->when;
+}
+
+//----------------------------------------------------------------------
+// EventLog::Replay
+// 	Hand over the next event of kind "type".  If the reader has less
+//	room than the event has data (a user program reading stdin with
+//	a smaller buffer than the one that made the log), the rest is
+//	kept for the next call.
+//
+//	Returns the number of bytes copied into "data"; 0 if the event
+//	carries none, or there are no events of this kind left.
+//
+//	"data" -- where to put the event's data
+//	"maxLength" -- how much room there is in "data"
+//----------------------------------------------------------------------
+
+int
+EventLog::Replay(EventType type, char *data, int maxLength)
+{
+    ListElement *element = pending[type]->getFirst();
+    LoggedEvent *event;
+    int length;
+
+    ASSERT(replaying);
+    if (element == NULL)
+	return 0;
+    event = (LoggedEvent *) element->item;
+    length = event->length - event->used;
+    if (length > maxLength)
+	length = maxLength;
+    if (length > 0)
+	bcopy(event->data + event->used, data, length);
+    event->used += length;
+    if (event->used == event->length) {
+	pending[type]->Remove();
+	delete event;
+    }
+    return length;
+}
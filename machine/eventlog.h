@@ -0,0 +1,83 @@
+// eventlog.h
+//	Data structures to record the events that come into Nachos from
+//	the outside world, and to play them back in a later run.
+//
+//	Everything the simulation does is determined by its inputs, so a
+//	run can be repeated exactly if it is given the same inputs at the
+//	same simulated times: the characters typed at the console (or
+//	read from stdin by a user program), the packets that arrive from
+//	the network, and, with -rs, the times at which the timer goes off.
+//	With -record, each of these is written to a log file together
+//	with the tick at which it happened; with -replay, the devices take
+//	their input from the log instead of from UNIX, each event being
+//	delivered when its tick comes around.
+//
+//	A kernel that has been changed can thus be run on exactly the
+//	inputs of an earlier run, and the difference in its statistics
+//	put down to the change.  When the kernel takes longer (or shorter)
+//	to get to a device than it did when the log was made, the event is
+//	delivered the next time the device looks for input after its tick;
+//	once the log runs out of events of some kind, that device goes
+//	back to its usual source of input.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "copyright.h"
+#include "list.h"
+
+#include <stdio.h>
+
+// The kinds of events that come from outside of Nachos
+enum EventType { TimerEvent,		// the random timer goes off (-rs)
+		 ConsoleEvent,		// a character arrives at the console
+		 StdinEvent,		// a user program reads stdin
+		 NetworkEvent,		// a packet arrives from the network
+		 NumEventTypes };
+
+// The following class defines an event read back from a log.
+
+class LoggedEvent {
+  public:
+    LoggedEvent(int time, char *contents, int size);
+    ~LoggedEvent();
+
+    int when;				// the tick at which it happened
+    char *data;				// what came in, if anything
+    int length;				// # of bytes in data
+    int used;				// # of bytes already delivered
+};
+
+// The following class defines a log of events, being either written
+// (-record) or played back (-replay).
+
+class EventLog {
+  public:
+    EventLog(char *fileName, bool replay);
+					// start a new log, or read the
+					// events from an old one
+    ~EventLog();			// close the log
+
+    bool IsRecording() { return !replaying; }
+    bool IsReplaying() { return replaying; }
+
+    void Record(EventType type, int when, char *data, int length);
+					// add an event to the log
+    int NextEvent(EventType type);	// when the next event of this
+					// type is due, or -1 if none is left
+    int Replay(EventType type, char *data, int maxLength);
+					// take (up to "maxLength" bytes of)
+					// the next event of this type, and
+					// return how many bytes were taken
+
+  private:
+    bool replaying;			// reading, rather than writing?
+    FILE *file;				// the log, if being written
+    List *pending[NumEventTypes];	// events yet to be replayed, by type
+};
+
+#endif // EVENTLOG_H
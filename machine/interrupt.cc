@@ -28,7 +28,13 @@
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv", "alarm"};
+
+#define NeverDue	0x7fffffff	// "nextDue" when nothing is pending
+#define PendingPoolChunk 32		// # of PendingInterrupts to allocate
+					// at once when the pool is empty
+
+static PendingInterrupt *freePending = NULL;	// the pool
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -48,6 +54,50 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
     arg = param;
     when = time;
     type = kind;
+    order = 0;
+    next = NULL;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new
+// 	Allocate a PendingInterrupt from the pool of free ones, refilling
+//	the pool a chunk at a time when it runs out.  PendingInterrupts
+//	are never given back to the system.
+//----------------------------------------------------------------------
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    PendingInterrupt *p;
+
+    ASSERT(size == sizeof(PendingInterrupt));
+    if (freePending == NULL) {
+	p = (PendingInterrupt *) 
+		::operator new(PendingPoolChunk * sizeof(PendingInterrupt));
+	for (int i = 0; i < PendingPoolChunk; i++) {
+	    p[i].next = freePending;
+	    freePending = &p[i];
+	}
+    }
+    p = freePending;
+    freePending = p->next;
+    return (void *) p;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator delete
+// 	Put a PendingInterrupt back in the pool.
+//----------------------------------------------------------------------
+
+void
+PendingInterrupt::operator delete(void *p)
+{
+    PendingInterrupt *pend = (PendingInterrupt *) p;
+
+    if (pend == NULL)
+	return;
+    pend->next = freePending;
+    freePending = pend;
 }
 
 //----------------------------------------------------------------------
@@ -60,10 +110,17 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    maxPending = 16;
+    pending = new PendingInterrupt *[maxPending];
+    numPending = 0;
+    nextOrder = 0;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
+    switchOnReturn = NULL;
     status = SystemMode;
+    nextDue = NeverDue;
+    skippedChecks = 0;
+    fastChecks = !DebugIsEnabled('i');
 }
 
 //----------------------------------------------------------------------
@@ -74,12 +131,12 @@ Interrupt::Interrupt()
 Interrupt::~Interrupt()
 {
     DEBUG('i', "~Interrupt\n");
-    while (!pending->IsEmpty()) {
+    while (numPending > 0) {
         DEBUG('i', "delete pending elements\n");
-        delete pending->Remove();
+        delete RemoveFirst();
     }
     DEBUG('i', "delete pending list\n");
-    delete pending;
+    delete [] pending;
 }
 
 //----------------------------------------------------------------------
@@ -154,8 +211,6 @@ Interrupt::Enable()
 void
 Interrupt::OneTick()
 {
-    MachineStatus old = status;
-
 // advance simulated time
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
@@ -166,6 +221,36 @@ Interrupt::OneTick()
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
+    CheckPending();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CheckPending
+// 	Fire off any pending interrupts that are now due, and then do the
+//	context switch (or the switch to another CPU) asked for by an
+//	interrupt handler, if any.  Simulated time is not advanced.
+//
+//	Called by OneTick, and by the threaded-code engine for user programs
+//	(Machine::RunThreaded), which advances the clock itself as it goes
+//	and only checks for interrupts at the end of each basic block.
+//
+//	Since this happens after every user instruction, we don't look at
+//	the pending list at all until the next interrupt could be due; we
+//	just count the check, so that CatchUp can later put the list in
+//	the order the skipped checks would have left it in.
+//----------------------------------------------------------------------
+void
+Interrupt::CheckPending()
+{
+    MachineStatus old = status;
+    VoidNoArgFunctionPtr switchCPU;
+    bool yield;
+
+    if (fastChecks && (stats->totalTicks < nextDue)) {
+	skippedChecks++;		// nothing can be due yet
+	return;
+    }
+
 // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
 					// (interrupt handlers run with
@@ -173,15 +258,42 @@ Interrupt::OneTick()
     while (CheckIfDue(FALSE))		// check for pending interrupts
 	;
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
-    if (yieldOnReturn) {		// if the timer device handler asked 
+    yield = yieldOnReturn;		// (these are for this CPU, so note
+    switchCPU = switchOnReturn;		// them before switching to another)
+    yieldOnReturn = FALSE;
+    switchOnReturn = NULL;
+    if (switchCPU != NULL) {		// if this CPU's time is up, let the
+ 	status = SystemMode;		// next CPU of a multiprocessor run
+	(*switchCPU)();			// (returns when it is our turn again)
+	status = old;
+    }
+    if (yield) {			// if the timer device handler asked 
 					// for a context switch, ok to do it now
-	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
 	currentThread->Yield();
 	status = old;
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::TicksUntilDue
+// 	Return how many ticks of simulated time can pass before the next
+//	pending interrupt could be due -- that is, before CheckPending
+//	might have something to do.  Used by the threaded-code engine to
+//	stop a basic block at the right instruction.
+//
+//	Returns 0 if every check must look at the pending list (for
+//	instance, to trace it for debugging).
+//----------------------------------------------------------------------
+
+int
+Interrupt::TicksUntilDue()
+{
+    if (!fastChecks || (nextDue <= stats->totalTicks))
+	return 0;
+    return nextDue - stats->totalTicks;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -200,6 +312,23 @@ Interrupt::YieldOnReturn()
     yieldOnReturn = TRUE; 
 }
 
+//----------------------------------------------------------------------
+// Interrupt::SwitchOnReturn
+// 	Called from within an interrupt handler, to have the interrupted
+//	thread give the host to another simulated CPU of a multiprocessor,
+//	when the handler returns.  As for YieldOnReturn, the switch can't
+//	be done in the handler itself.
+//
+//	"func" is the kernel routine that does the switch.
+//----------------------------------------------------------------------
+
+void
+Interrupt::SwitchOnReturn(VoidNoArgFunctionPtr func)
+{ 
+    ASSERT(inHandler == TRUE);  
+    switchOnReturn = func; 
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Idle
 // 	Routine called when there is nothing in the ready queue.
@@ -221,6 +350,7 @@ Interrupt::Idle()
 	    ;				// interrupts
         yieldOnReturn = FALSE;		// since there's nothing in the
 					// ready queue, the yield is automatic
+        switchOnReturn = NULL;		// nor is any CPU busy
         status = SystemMode;
 	return;				// return in case there's now
 					// a runnable thread
@@ -246,6 +376,16 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    if (schedStats != NULL) {
+	schedStats->Print();
+	schedStats->Write();
+    }
+    if (tracer != NULL)
+	tracer->Write();
+#ifdef USER_PROGRAM
+    if (profiler != NULL)
+	profiler->Print();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -254,7 +394,9 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it on a binary heap, ordered by when it is
+//	to occur.  Interrupts scheduled for the same time occur in the
+//	order they were scheduled.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -275,7 +417,11 @@ Interrupt::Schedule(VoidFunctionPtr handler, _int arg, int fromNow, IntType type
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    CatchUp();
+    toOccur->order = nextOrder++;	// after any others due at "when"
+    Insert(toOccur);
+    if (when < nextDue)
+	nextDue = when;
 }
 
 //----------------------------------------------------------------------
@@ -299,28 +445,33 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
+    CatchUp();
     if (DebugIsEnabled('i'))
 	    DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
 
-    if (toOccur == NULL)		// no pending interrupts
+    if (numPending == 0) {		// no pending interrupts
+	nextDue = NeverDue;
 	return FALSE;			
+    }
+    PendingInterrupt *toOccur = pending[0];
+    when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {	// not time yet
+	skippedChecks++;		// see CatchUp
+	nextDue = when;			// it's the earliest one
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& (numPending == 1)) {
+	 nextDue = when;
 	 return FALSE;
     }
+    RemoveFirst();
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
@@ -332,13 +483,142 @@ Interrupt::CheckIfDue(bool advanceClock)
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
+    if (tracer != NULL)
+	tracer->Begin(TraceInterrupts, "interrupt",
+		      intTypeNames[toOccur->type]);
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
+    if (tracer != NULL)
+	tracer->End(TraceInterrupts, "interrupt", intTypeNames[toOccur->type]);
     status = old;				// restore the machine status
     inHandler = FALSE;
     delete toOccur;
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Interrupt::CatchUp
+// 	Make up for the checks that found nothing due (including those
+//	CheckPending skipped entirely), before anyone looks at the pending
+//	interrupts again.
+//
+//	Originally, the pending interrupts were kept on a sorted list, and
+//	each such check took the first one off the list and put it back --
+//	behind any others scheduled for the same time.  So the group of
+//	interrupts due first was rotated once per check.  We do the
+//	rotations here, so that interrupts due at the same time still
+//	fire in exactly the same order as before.
+//----------------------------------------------------------------------
+
+void
+Interrupt::CatchUp()
+{
+    int i, groupSize, rotations;
+    PendingInterrupt *first;
+
+    if (skippedChecks == 0)
+	return;
+    if (numPending > 1) {
+	first = pending[0];
+	for (groupSize = 0, i = 0; i < numPending; i++)
+	    if (pending[i]->when == first->when)
+		groupSize++;
+	for (rotations = skippedChecks % groupSize; rotations > 0; 
+							rotations--) {
+	    pending[0]->order = nextOrder++;	// to the back of the group
+	    SiftDown(0);
+	}
+    }
+    skippedChecks = 0;
+}
+
+//----------------------------------------------------------------------
+// Earlier
+// 	Return TRUE if interrupt "a" should fire before interrupt "b".
+//
+//	"order" is a counter that wraps around after 2^32 interrupts, so
+//	it is compared by the sign of the difference.  This is right as
+//	long as no interrupt stays pending while 2^31 others are
+//	scheduled; only a handful are ever pending at once.
+//----------------------------------------------------------------------
+
+static bool
+Earlier(PendingInterrupt *a, PendingInterrupt *b)
+{
+    if (a->when != b->when)
+	return (a->when < b->when);
+    return ((int) (a->order - b->order) < 0);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Insert
+// 	Put an interrupt on the heap of pending interrupts, growing the 
+//	heap if need be.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Insert(PendingInterrupt *toOccur)
+{
+    int i, parent;
+
+    if (numPending == maxPending) {
+	PendingInterrupt **bigger = new PendingInterrupt *[maxPending * 2];
+
+	for (i = 0; i < numPending; i++)
+	    bigger[i] = pending[i];
+	delete [] pending;
+	pending = bigger;
+	maxPending *= 2;
+    }
+    for (i = numPending++; i > 0; i = parent) {	// sift up
+	parent = (i - 1) / 2;
+	if (!Earlier(toOccur, pending[parent]))
+	    break;
+	pending[i] = pending[parent];
+    }
+    pending[i] = toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RemoveFirst
+// 	Take the interrupt that is to fire next off the heap, and
+//	return it.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+Interrupt::RemoveFirst()
+{
+    PendingInterrupt *first = pending[0];
+
+    ASSERT(numPending > 0);
+    pending[0] = pending[--numPending];
+    if (numPending > 0)
+	SiftDown(0);
+    return first;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SiftDown
+// 	Move pending[i] down the heap until it fires no earlier than its
+//	children.
+//----------------------------------------------------------------------
+
+void
+Interrupt::SiftDown(int i)
+{
+    PendingInterrupt *item = pending[i];
+    int child;
+
+    for (; (child = 2 * i + 1) < numPending; i = child) {
+	if ((child + 1 < numPending) && 
+			Earlier(pending[child + 1], pending[child]))
+	    child++;
+	if (!Earlier(pending[child], item))
+	    break;
+	pending[i] = pending[child];
+    }
+    pending[i] = item;
+}
+
 //----------------------------------------------------------------------
 // PrintPending
 // 	Print information about an interrupt that is scheduled to occur.
@@ -363,11 +643,101 @@ PrintPending(_int arg)
 void
 Interrupt::DumpState()
 {
+    PendingInterrupt **sorted = new PendingInterrupt *[numPending + 1];
+    int i, j;
+
+    CatchUp();
     printf("Time: %d, interrupts %s\n", stats->totalTicks, 
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    for (i = 0; i < numPending; i++) {	// print in the order they'll fire
+	sorted[i] = pending[i];
+	for (j = i; (j > 0) && Earlier(sorted[j], sorted[j - 1]); j--) {
+	    PendingInterrupt *tmp = sorted[j];
+	    sorted[j] = sorted[j - 1];
+	    sorted[j - 1] = tmp;
+	}
+    }
+    for (i = 0; i < numPending; i++)
+	PrintPending((_int) sorted[i]);
+    delete [] sorted;
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
+
+//----------------------------------------------------------------------
+// Interrupt::Checkpoint
+// 	Write the interrupts that are scheduled to occur to the open UNIX
+//	file "fd", for a checkpoint of the simulation.  This must be done
+//	outside any interrupt handler.
+//
+//	Handlers and their arguments are addresses in this run of Nachos,
+//	so only when and what kind each interrupt is can be saved; see
+//	Restore.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Checkpoint(int fd)
+{
+    int i;
+
+    ASSERT(!inHandler);
+    CatchUp();				// so that "order" says it all
+    WriteFile(fd, (char *) &numPending, sizeof(int));
+    WriteFile(fd, (char *) &nextOrder, sizeof(unsigned int));
+    for (i = 0; i < numPending; i++) {
+	WriteFile(fd, (char *) &pending[i]->when, sizeof(int));
+	WriteFile(fd, (char *) &pending[i]->order, sizeof(unsigned int));
+	WriteFile(fd, (char *) &pending[i]->type, sizeof(IntType));
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Restore
+// 	Replace the pending interrupts by those written by Checkpoint.
+//
+//	Each one is given the handler (and argument) of an interrupt of
+//	the same kind that is pending now: the devices must have been
+//	started up just as they were in the run that was checkpointed
+//	(for instance, the timer, with the same -rs flag), and each of
+//	them must have scheduled an interrupt.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Restore(int fd)
+{
+    PendingInterrupt **now = pending;
+    int numNow = numPending;
+    PendingInterrupt *toOccur, *same;
+    int count, when, i, j;
+    unsigned int order;
+    IntType type;
+
+    ASSERT(!inHandler);
+    pending = new PendingInterrupt *[maxPending];
+    numPending = 0;
+    Read(fd, (char *) &count, sizeof(int));
+    Read(fd, (char *) &nextOrder, sizeof(unsigned int));
+    for (i = 0; i < count; i++) {
+	Read(fd, (char *) &when, sizeof(int));
+	Read(fd, (char *) &order, sizeof(unsigned int));
+	Read(fd, (char *) &type, sizeof(IntType));
+	for (same = NULL, j = 0; (same == NULL) && (j < numNow); j++)
+	    if (now[j]->type == type)
+		same = now[j];
+	if (same == NULL) {
+	    printf("No device to restore the %s interrupt for.\n", 
+							intTypeNames[type]);
+	    ASSERT(FALSE);
+	}
+	toOccur = new PendingInterrupt(same->handler, same->arg, when, type);
+	toOccur->order = order;
+	Insert(toOccur);
+    }
+    for (j = 0; j < numNow; j++)
+	delete now[j];
+    delete [] now;
+    skippedChecks = 0;
+    nextDue = (numPending > 0) ? pending[0]->when : NeverDue;
+}
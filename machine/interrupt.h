@@ -48,13 +48,17 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network; the kernel's alarm clock
+// (threads/alarm.cc) schedules interrupts of its own.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
+//
+// PendingInterrupts are allocated from a pool of free ones, since
+// every disk, console, network and timer operation needs one.
 
 class PendingInterrupt {
   public:
@@ -62,11 +66,17 @@ class PendingInterrupt {
 				// initialize an interrupt that will
 				// occur in the future
 
+    void *operator new(size_t size);	// allocate from the pool
+    void operator delete(void *p);	// and put it back
+
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     _int arg;           // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned int order;		// Of interrupts due at the same time, 
+				// the one with the lowest order fires first
+    PendingInterrupt *next;	// Next in the pool of free ones
 };
 
 // The following class defines the data structures for the simulation
@@ -94,11 +104,20 @@ class Interrupt {
     
     void YieldOnReturn();		// cause a context switch on return 
 					// from an interrupt handler
+    void SwitchOnReturn(VoidNoArgFunctionPtr func);
+					// call "func" (which switches to 
+					// another CPU) on return from an
+					// interrupt handler
 
+    bool InHandler() { return inHandler; }
+					// Is an interrupt handler running?
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
+
+    void Checkpoint(int fd);		// Save the pending interrupts to 
+    void Restore(int fd);		// a UNIX file, and read them back
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -111,20 +130,49 @@ class Interrupt {
     					// by the hardware device simulators.
     
     void OneTick();       		// Advance simulated time
+    void CheckPending();		// Fire any interrupts that are due,
+					// without advancing simulated time
+    int TicksUntilDue();		// How long until an interrupt might
+					// be due; 0 if we must check now
+    void SkipChecks(int count) { skippedChecks += count; }
+					// Account for "count" calls to
+					// CheckPending that the caller knows
+					// would have found nothing due
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingInterrupt **pending;	// the interrupts scheduled to occur in
+				// the future, as a binary heap on
+				// (when, order): the next to fire is
+				// always pending[0]
+    int numPending;		// # of interrupts in "pending"
+    int maxPending;		// size of the "pending" array
+    unsigned int nextOrder;	// "order" for the next interrupt
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
+    VoidNoArgFunctionPtr switchOnReturn;
+				// what to call on return from the
+				// interrupt handler to switch CPUs, or NULL
     MachineStatus status;	// idle, kernel mode, user mode
+    int nextDue;		// no interrupt is due before this time
+    int skippedChecks;		// # of times CheckPending has found
+				// nothing due without looking at "pending"
+    bool fastChecks;		// FALSE if we must look at "pending" on
+				// every check, to trace it for debugging
 
     // these functions are internal to the interrupt simulation code
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
+    void CatchUp();			// Bring "pending" up to date with 
+					// the checks that were skipped
+
+    void Insert(PendingInterrupt *toOccur);
+					// Add an interrupt to the heap
+    PendingInterrupt *RemoveFirst();	// Take the next one off the heap
+    void SiftDown(int i);		// Restore the heap order below
+					// pending[i]
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
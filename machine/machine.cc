@@ -44,34 +44,103 @@ void CheckEndian()
 #endif
 }
 
+// The size of physical memory and the shape of the TLB (see machine.h)
+int NumPhysPages = DefaultNumPhysPages;
+#ifdef USE_TLB
+int TLBSize = DefaultTLBSize;
+#else
+int TLBSize = 0;		// use a linear page table, unless -tlb is given
+#endif
+int TLBAssoc = 0;
+TLBPolicy TLBReplacement = TLBFifo;
+bool HostOrderMemory = FALSE;
+bool BigEndianMemory = FALSE;
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"threaded" -- if TRUE, run user programs with the threaded-code
+//		engine rather than one instruction at a time.
+//	"boot" -- if non-NULL, this is another CPU of a multiprocessor:
+//		it has its own registers and TLB, but shares main memory
+//		(and the predecoded instructions) with the CPU "boot".
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool threaded, Machine *boot)
 {
     int i;
+    bool bigEndian;		// is main memory kept big-endian?
 
+    ASSERT((NumPhysPages > 0) && (TLBSize >= 0));
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
-      	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
+    if (boot != NULL) {
+	mainMemory = boot->mainMemory;
+	decodeCache = boot->decodeCache;
+	decodeValid = boot->decodeValid;
+	blockLength = boot->blockLength;
+	frameDecoded = boot->frameDecoded;
+    } else {
+	mainMemory = new char[MemorySize];
+	for (i = 0; i < MemorySize; i++)
+	    mainMemory[i] = 0;
+	decodeCache = new Instruction[MemorySize / 4];
+	decodeValid = new bool[MemorySize / 4];
+	blockLength = new unsigned char[MemorySize / 4];
+	for (i = 0; i < MemorySize / 4; i++) {
+	    decodeValid[i] = FALSE;
+	    blockLength[i] = 0;
+	}
+	frameDecoded = new bool[NumPhysPages];
+	for (i = 0; i < NumPhysPages; i++)
+	    frameDecoded[i] = FALSE;
+    }
+    sharedMemory = (boot != NULL);
+    if (TLBSize > 0) {
+	tlbWays = (TLBAssoc > 0) ? TLBAssoc : TLBSize;
+	ASSERT((tlbWays <= TLBSize) && (TLBSize % tlbWays == 0));
+	ASSERT(tlbWays >= 2);	// an instruction may need two pages (its
+				// own, and the one it loads or stores);
+				// with one way, if both pages map to the
+				// same set, it could never run
+	tlbSets = TLBSize / tlbWays;
+	tlb = new TranslationEntry[TLBSize];
+	tlbLoaded = new unsigned int[TLBSize];
+	tlbRecent = new bool[TLBSize];
+	for (i = 0; i < TLBSize; i++) {
+	    tlb[i].valid = FALSE;
+	    tlbLoaded[i] = 0;
+	    tlbRecent[i] = FALSE;
+	}
+	tlbLoads = 0;
+    } else {		// use linear page table
+	tlb = NULL;
+	tlbLoaded = NULL;
+	tlbRecent = NULL;
+    }
     pageTable = NULL;
-#endif
+    refillTable = NULL;
+    refillTableSize = 0;
 
     singleStep = debug;
+    threadedCode = threaded;
+    instrumented = singleStep || DebugIsEnabled('m') || DebugIsEnabled('a');
+    blockStartTicks = NotInBlock;
+    hiloBusyTicks = 0;
+    translationCacheOn = !DebugIsEnabled('a') && (tlb == NULL);
+#ifdef HOST_IS_BIG_ENDIAN
+    bigEndian = HostOrderMemory || BigEndianMemory;
+    hostOrder = bigEndian;
+#else
+    bigEndian = BigEndianMemory;	// -hostorder changes nothing: the two
+    hostOrder = !bigEndian;		// byte orders are the same
+#endif
+    byteSwizzle = bigEndian ? 3 : 0;	// byte 0 of a little-endian word is
+    shortSwizzle = bigEndian ? 2 : 0;	// the last byte of a big-endian one
+    FlushTranslationCache();
     CheckEndian();
 }
 
@@ -82,9 +151,18 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
-    if (tlb != NULL)
+    if (!sharedMemory) {	// the boot CPU must be deleted last
+	delete [] mainMemory;
+	delete [] decodeCache;
+	delete [] decodeValid;
+	delete [] frameDecoded;
+	delete [] blockLength;
+    }
+    if (tlb != NULL) {
         delete [] tlb;
+	delete [] tlbLoaded;
+	delete [] tlbRecent;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -93,6 +171,11 @@ Machine::~Machine()
 //	the user program either invoked a system call, or some exception
 //	occured (such as the address translation failed).
 //
+//	If we are in the middle of a basic block in the threaded-code
+//	engine, the instructions before this one have not had their
+//	interrupt checks counted yet; that has to be done before the
+//	kernel runs (see RunThreaded).
+//
 //	"which" -- the cause of the kernel trap
 //	"badVaddr" -- the virtual address causing the trap, if appropriate
 //----------------------------------------------------------------------
@@ -102,6 +185,10 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 {
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
     
+    if (blockStartTicks != NotInBlock) {
+	interrupt->SkipChecks((stats->totalTicks - blockStartTicks) / UserTick);
+	blockStartTicks = NotInBlock;
+    }
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
@@ -112,6 +199,200 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     interrupt->setStatus(UserMode);
 }
 
+//----------------------------------------------------------------------
+// Machine::TLBVictim
+// 	Choose the TLB entry into which the kernel should load the 
+//	translation for "virtualPage", on a TLB miss.  It is in the set
+//	for the page: an empty entry if there is one, otherwise the one
+//	picked by the replacement policy.
+//
+//	The kernel must copy the use and dirty bits of the old entry back
+//	to its page table (if the entry is valid), before overwriting it.
+//
+//	"virtualPage" -- the page whose translation is to be loaded
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Machine::TLBVictim(int virtualPage)
+{
+    int first, way, i;
+
+    ASSERT(tlb != NULL);
+    first = ((unsigned) virtualPage % tlbSets) * tlbWays;
+    for (way = 0; way < tlbWays; way++)
+	if (!tlb[first + way].valid)
+	    break;
+    if (way == tlbWays) {		// the set is full
+	switch (TLBReplacement) {
+	  case TLBRandom:
+	    way = Random() % tlbWays;
+	    break;
+	  case TLBFifo:
+	    for (way = 0, i = 1; i < tlbWays; i++)
+		if (tlbLoaded[first + i] < tlbLoaded[first + way])
+		    way = i;
+	    break;
+	  case TLBPseudoLRU:		// TLBTouch leaves one bit clear,
+					// unless there is only one way
+	    for (way = 0; (way < tlbWays - 1) && tlbRecent[first + way]; 
+								way++)
+		;
+	    break;
+	}
+    }
+    tlbLoaded[first + way] = ++tlbLoads;
+    TLBTouch(first + way);
+    stats->process->refills++;
+    return &tlb[first + way];
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBTouch
+// 	Note that TLB entry "i" has just been used, for pseudo-LRU 
+//	replacement: each entry has a bit that is set when it is used,
+//	and once all the bits in a set are on, all but the latest are
+//	cleared.  So there is always an entry in the set that has not
+//	been used recently, to be replaced next.
+//----------------------------------------------------------------------
+
+void
+Machine::TLBTouch(int i)
+{
+    int first = (i / tlbWays) * tlbWays;
+    int way;
+
+    tlbRecent[i] = TRUE;
+    for (way = 0; way < tlbWays; way++)
+	if (!tlbRecent[first + way])
+	    return;
+    for (way = 0; way < tlbWays; way++)
+	tlbRecent[first + way] = FALSE;
+    tlbRecent[i] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::ConvertLoadedImage
+// 	Convert part of main memory that has just been read from a NOFF
+//	file, where it is in the simulated machine's byte order, into the
+//	order main memory is kept in: if it is kept big-endian, each word
+//	is swapped; otherwise there is nothing to do.
+//
+//	Whole words are swapped, so segments must start and end on word
+//	boundaries, as they always do in a NOFF file.
+//
+//	"physAddr" -- where the bytes were read to
+//	"size" -- how many bytes were read
+//----------------------------------------------------------------------
+
+void
+Machine::ConvertLoadedImage(int physAddr, int size)
+{
+    unsigned int *word;
+    int i;
+
+    if (byteSwizzle == 0)
+	return;
+    ASSERT((physAddr % 4) == 0);
+    word = (unsigned int *) &mainMemory[physAddr];
+    for (i = 0; i < divRoundUp(size, 4); i++)
+	word[i] = SwapWord(word[i]);
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedFrame
+// 	Throw away the predecoded instructions for a physical page frame,
+//	so that they are fetched and decoded again on their next execution.
+//	WriteMem does this itself; the kernel must call it when it changes
+//	the contents of a frame directly (eg, when loading a program into
+//	a newly allocated frame).
+//
+//	This also throws away the basic blocks found in the frame by the
+//	threaded-code engine.
+//
+//	"frame" -- the physical page number whose contents changed
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodedFrame(int frame)
+{
+    int first = frame * PageSize / 4;
+
+    ASSERT((frame >= 0) && (frame < NumPhysPages));
+    if (!frameDecoded[frame])
+	return;
+    for (int i = 0; i < PageSize / 4; i++) {
+	decodeValid[first + i] = FALSE;
+	blockLength[first + i] = 0;
+    }
+    frameDecoded[frame] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Machine::Checkpoint
+// 	Write the state of this CPU -- its registers, main memory, and
+//	the TLB (if any) -- to the open UNIX file "fd", for a checkpoint
+//	of the simulation.  Called from the kernel, between user 
+//	instructions.
+//
+//	Main memory is saved in the simulated machine's byte order, as in
+//	a NOFF file, so that it doesn't matter which order it was kept in
+//	(see HostOrderMemory and BigEndianMemory).
+//----------------------------------------------------------------------
+
+void
+Machine::Checkpoint(int fd)
+{
+    char *image = mainMemory;
+    int i;
+
+    WriteFile(fd, (char *) registers, sizeof(registers));
+    WriteFile(fd, (char *) &hiloBusyTicks, sizeof(int));
+    if (byteSwizzle != 0) {		// kept big-endian
+	image = new char[MemorySize];
+	for (i = 0; i < MemorySize; i += 4)
+	    *(unsigned int *) &image[i] = 
+		SwapWord(*(unsigned int *) &mainMemory[i]);
+    }
+    WriteFile(fd, image, MemorySize);
+    if (image != mainMemory)
+	delete [] image;
+    if (tlb != NULL) {
+	WriteFile(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
+	WriteFile(fd, (char *) tlbLoaded, TLBSize * sizeof(unsigned int));
+	WriteFile(fd, (char *) tlbRecent, TLBSize * sizeof(bool));
+	WriteFile(fd, (char *) &tlbLoads, sizeof(unsigned int));
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::Restore
+// 	Read back the state written by Checkpoint, on a machine with the
+//	same size of memory and the same shape of TLB.  Everything that
+//	was derived from the old contents of memory (predecoded 
+//	instructions, cached translations) is thrown away.
+//----------------------------------------------------------------------
+
+void
+Machine::Restore(int fd)
+{
+    int i;
+
+    Read(fd, (char *) registers, sizeof(registers));
+    Read(fd, (char *) &hiloBusyTicks, sizeof(int));
+    Read(fd, mainMemory, MemorySize);
+    ConvertLoadedImage(0, MemorySize);
+    for (i = 0; i < NumPhysPages; i++)
+	InvalidateDecodedFrame(i);
+    if (tlb != NULL) {
+	Read(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
+	Read(fd, (char *) tlbLoaded, TLBSize * sizeof(unsigned int));
+	Read(fd, (char *) tlbRecent, TLBSize * sizeof(bool));
+	Read(fd, (char *) &tlbLoads, sizeof(unsigned int));
+    }
+    blockStartTicks = NotInBlock;
+    FlushTranslationCache();
+}
+
 //----------------------------------------------------------------------
 // Machine::Debugger
 // 	Primitive debugger for user programs.  Note that we can't use
@@ -23,6 +23,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "stats.h"
 #include "translate.h"
 #include "disk.h"
 
@@ -32,9 +33,48 @@
 					// the disk sector size, for
 					// simplicity
 
-#define NumPhysPages    64 //32
+// The amount of physical memory and the shape of the TLB can be set on
+// the command line (-mem, -tlb, -tlbassoc and -tlbpolicy, see 
+// threads/system.cc) before the Machine is created; they must not 
+// change after that.
+//
+// The TLB is split into TLBSize / TLBAssoc sets of TLBAssoc entries
+// each; a virtual page can only be cached in set (page # % # of sets).
+// When a set is full, TLBReplacement says which entry to give up.
+
+#define DefaultNumPhysPages	64	//32
+#define DefaultTLBSize		4	// if there is a TLB, make it small
+
+enum TLBPolicy { TLBRandom,		// any entry in the set
+		 TLBFifo,		// the one loaded longest ago
+		 TLBPseudoLRU		// one not used recently
+};
+
+extern int NumPhysPages;		// # of page frames of physical memory
+extern int TLBSize;			// # of entries in the TLB; 0 if we use
+					// a linear page table instead
+extern int TLBAssoc;			// # of entries in each TLB set; 0 
+					// means fully associative
+extern TLBPolicy TLBReplacement;	// which TLB entry to replace
+extern bool HostOrderMemory;		// keep main memory in the host's
+					// byte order, rather than the
+					// simulated machine's (-hostorder)
+extern bool BigEndianMemory;		// keep main memory big-endian, on
+					// any host (-bigendian); to test
+					// the code for -hostorder on a
+					// big-endian host, on a little-
+					// endian one
+
+// The cost model (-cost, see costmodel.cc) charges each user instruction
+// InstrTicks for its kind, plus any pipeline stalls, instead of UserTick.
+
+extern bool ModelCosts;			// is the cost model on?
+extern int InstrTicks[NumInstrClasses];	// ticks for each kind of instruction
+extern int LoadUseTicks;		// stall for using a register just
+					// loaded
+extern void SetCosts(char *spec);	// turn the cost model on, with the
+					// costs changed as "spec" says
 #define MemorySize 	(NumPhysPages * PageSize)
-#define TLBSize		4		// if there is a TLB, make it small
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -71,6 +111,8 @@ enum ExceptionType { NoException,           // Everything ok!
 
 #define NumTotalRegs 	40
 
+#define NotInBlock	-1	// see Machine::blockStartTicks
+
 // The following class defines an instruction, represented in both
 // 	undecoded binary form
 //      decoded to identify
@@ -85,12 +127,116 @@ class Instruction {
     unsigned int value; // binary representation of the instruction
 
     char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
+    		     // opcode field from the instruction: see defs below
     char rs, rt, rd; // Three registers from instruction.
     int extra;       // Immediate or target or shamt field or offset.
                      // Immediates are sign-extended.
 };
 
+/*
+ * OpCode values.  The names are straight from the MIPS
+ * manual except for the following special ones:
+ *
+ * OP_UNIMP -		means that this instruction is legal, but hasn't
+ *			been implemented in the simulator yet.
+ * OP_RES -		means that this is a reserved opcode (it isn't
+ *			supported by the architecture).
+ */
+
+#define OP_ADD		1
+#define OP_ADDI		2
+#define OP_ADDIU	3
+#define OP_ADDU		4
+#define OP_AND		5
+#define OP_ANDI		6
+#define OP_BEQ		7
+#define OP_BGEZ		8
+#define OP_BGEZAL	9
+#define OP_BGTZ		10
+#define OP_BLEZ		11
+#define OP_BLTZ		12
+#define OP_BLTZAL	13
+#define OP_BNE		14
+
+#define OP_DIV		16
+#define OP_DIVU		17
+#define OP_J		18
+#define OP_JAL		19
+#define OP_JALR		20
+#define OP_JR		21
+#define OP_LB		22
+#define OP_LBU		23
+#define OP_LH		24
+#define OP_LHU		25
+#define OP_LUI		26
+#define OP_LW		27
+#define OP_LWL		28
+#define OP_LWR		29
+
+#define OP_MFHI		31
+#define OP_MFLO		32
+
+#define OP_MTHI		34
+#define OP_MTLO		35
+#define OP_MULT		36
+#define OP_MULTU	37
+#define OP_NOR		38
+#define OP_OR		39
+#define OP_ORI		40
+#define OP_RFE		41
+#define OP_SB		42
+#define OP_SH		43
+#define OP_SLL		44
+#define OP_SLLV		45
+#define OP_SLT		46
+#define OP_SLTI		47
+#define OP_SLTIU	48
+#define OP_SLTU		49
+#define OP_SRA		50
+#define OP_SRAV		51
+#define OP_SRL		52
+#define OP_SRLV		53
+#define OP_SUB		54
+#define OP_SUBU		55
+#define OP_SW		56
+#define OP_SWL		57
+#define OP_SWR		58
+#define OP_XOR		59
+#define OP_XORI		60
+#define OP_SYSCALL	61
+#define OP_UNIMP	62
+#define OP_RES		63
+#define MaxOpcode	63
+
+/*
+ * Miscellaneous definitions:
+ */
+
+#define IndexToAddr(x) ((x) << 2)
+
+#define SIGN_BIT	0x80000000
+#define R31		31
+
+// Simulate R2000 multiplication (shared by both execution engines, see
+// mipssim.cc)
+
+extern void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+
+// The following class defines an entry in the translation cache: a
+// virtual page that Translate has recently mapped, and the page frame
+// it maps to.  ReadMem, WriteMem and instruction fetch look here first,
+// and only call Translate on a miss (see Machine::CachedTranslate).
+
+class TranslationCacheEntry {
+  public:
+    unsigned int virtualPage;	// the page, or NoCachedPage if unused
+    int physicalPage;		// the page frame holding it
+};
+
+#define TranslationCacheSize	64	// entries in each direct-mapped
+					// translation cache
+#define NoCachedPage	((unsigned int) -1)
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -106,8 +252,11 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, bool threaded = FALSE, Machine *boot = NULL);
+				// Initialize the simulation of the hardware
+				// for running user programs; "boot" is
+				// the CPU to share main memory with, if
+				// this is one of several
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -118,19 +267,64 @@ class Machine {
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void Checkpoint(int fd);	// save the registers, memory and TLB
+    void Restore(int fd);	// to a UNIX file, and read them back
+
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
+    void RunUntilMoved();	// Run a user program on this CPU, until
+				// the kernel moves it to another one
+
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    template <bool Instrumented> void RunLoop();
+				// Run a user program one instruction at a
+				// time (until it is moved to another CPU);
+				// with "Instrumented" FALSE, without any
+				// debugging support
+    template <bool Instrumented> void Execute(Instruction *instr);
+				// Run one instruction, as OneInstruction
+    void RunThreaded();		// Run a user program a basic block at a
+				// time, with the threaded-code engine
+				// (see mipsblock.cc)
+    int ExecuteBlock(int slot, int limit);
+				// Run up to "limit" instructions of the
+				// basic block starting at word "slot" of
+				// physical memory
+    int BuildBlock(int slot);	// Find the extent of the basic block
+				// starting at word "slot"
+    bool FetchInstruction(int addr, Instruction *instr);
+				// Fetch and decode the instruction at
+				// virtual address "addr", using the
+				// predecoded copy if there is one.
+				// Return FALSE on an exception.
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
+    void ChargeCost(Instruction *instr);
+				// Charge the time "instr" takes under
+				// the cost model (see costmodel.cc)
     
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+    template <bool Instrumented> bool ReadMemory(int addr, int size,
+						 int* value);
+    template <bool Instrumented> bool WriteMemory(int addr, int size,
+						  int value);
+				// Same, but with no 'a' debug messages if
+				// "Instrumented" is FALSE
+
+    bool CopyFromUser(int virtAddr, char *buffer, int size);
+    bool CopyToUser(int virtAddr, char *buffer, int size);
+				// Copy "size" bytes between user virtual
+				// memory and a kernel buffer, a page at a
+				// time.  Return FALSE if the copy faulted.
+    int CopyStringFromUser(int virtAddr, char *buffer, int maxSize);
+				// Copy a null-terminated string from user
+				// memory; return its length, or -1
     
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
@@ -138,6 +332,39 @@ class Machine {
 				// the translation entry appropriately,
     				// and return an exception code if the 
 				// translation couldn't be completed.
+    ExceptionType CachedTranslate(int virtAddr, int* physAddr, int size,
+				  bool writing);
+				// Same as Translate, but use the
+				// translation cache if we can.
+    ExceptionType TranslateForCopy(int virtAddr, int* physAddr,
+				   bool writing);
+				// Same as Translate, but let the kernel
+				// handle TLB misses.
+
+    void FlushTranslationCache();
+				// Forget every cached translation.  The
+				// kernel must call this whenever it
+				// switches page tables, or changes a
+				// page table or TLB entry in use.
+
+    TranslationEntry *TLBVictim(int virtualPage);
+				// Return the TLB entry that a translation
+				// for "virtualPage" should be loaded
+				// into, following TLBReplacement.  The
+				// caller must save the old contents, if
+				// they are valid.
+
+    void ConvertLoadedImage(int physAddr, int size);
+				// Put "size" bytes just read into main
+				// memory from a file, in the simulated
+				// machine's byte order, into the byte
+				// order main memory is kept in.
+
+    void InvalidateDecodedFrame(int frame);
+				// Forget any predecoded instructions
+				// for physical page "frame"; called when
+				// the frame's contents are changed
+				// behind WriteMem's back.
 
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
@@ -154,7 +381,8 @@ class Machine {
 // are in terms of these data structures.
 
     char *mainMemory;		// physical memory to store user program,
-				// code and data, while executing
+				// code and data, while executing; see
+				// HostOrderMemory for its byte order
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
 
@@ -175,6 +403,10 @@ class Machine {
 // space, stored in memory), there is only one TLB (implemented in hardware).
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
+//
+// Translations are also cached inside the simulated machine, so after
+// modifying the TLB, or a page table that is in use (or on loading a
+// different page table), the kernel must call FlushTranslationCache.
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
@@ -182,11 +414,63 @@ class Machine {
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    TranslationEntry *refillTable;	// with a TLB, the page table the
+    unsigned int refillTableSize;	// kernel refills it from, if the
+					// kernel sets it; the kernel's own
+					// copies (TranslateForCopy) check
+					// addresses against it
+
   private:
+    void DecodeSlot(int slot);	// decode word "slot" of physical memory
+				// into decodeCache
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+    bool instrumented;		// is any debugging support needed to run
+				// user programs (single stepping, or the 'm'
+				// or 'a' debug flags)?
+
+    bool sharedMemory;		// are main memory and the arrays below
+				// another CPU's?
+    Instruction *decodeCache;	// predecoded instructions, one slot for
+				// each word of physical memory
+    bool *decodeValid;		// is the matching decodeCache slot filled?
+    bool *frameDecoded;		// does the page frame have any filled
+				// decodeCache slots?
+    bool threadedCode;		// run user programs with RunThreaded?
+    unsigned char *blockLength;	// # of instructions in the basic block
+				// starting at each word of physical memory,
+				// 0 if not yet known
+    int blockStartTicks;	// when the basic block being run started,
+				// or NotInBlock
+    int hiloBusyTicks;		// how long until the MULT or DIV being
+				// run finishes, for the cost model
+
+    TranslationCacheEntry readCache[TranslationCacheSize];
+    TranslationCacheEntry writeCache[TranslationCacheSize];
+				// recent translations for reads (and
+				// fetches) and for writes, by virtual
+				// page # modulo TranslationCacheSize
+    bool translationCacheOn;	// FALSE if address debugging is on, so
+				// that every access is still traced, or
+				// if every access must go to the TLB
+
+    bool hostOrder;		// is main memory in host byte order? 
+				// if not, words and short words are
+				// swapped on every load and store
+    int byteSwizzle;		// what to xor into the address of a byte,
+    int shortSwizzle;		// or a short word, to find it in main 
+				// memory: non-zero only if memory is
+				// kept big-endian
+
+    void TLBTouch(int i);	// note that TLB entry "i" was used
+    int tlbSets;		// # of sets in the TLB
+    int tlbWays;		// # of entries in each set
+    unsigned int *tlbLoaded;	// when each TLB entry was loaded (FIFO)
+    unsigned int tlbLoads;	// # of TLB entries loaded so far
+    bool *tlbRecent;		// has each entry been used recently? (LRU)
 };
 
 extern void ExceptionHandler(ExceptionType which);
@@ -204,11 +488,21 @@ extern void ExceptionHandler(ExceptionType which);
 //	   kernel data structures
 //	   user registers
 //	simulated machine byte ordering:
-//	   contents of main memory
+//	   contents of main memory (unless HostOrderMemory is set:
+//	   then each word of main memory is kept in host order, and 
+//	   bytes and short words within it are found by changing their
+//	   address, so that loads and stores need no swapping; or 
+//	   BigEndianMemory, which does the same on any host, swapping
+//	   each word if the host is little-endian)
+//	   the contents of NOFF files
+//
+// SwapWord and SwapShort always reverse the bytes, whatever the host.
 
 unsigned int WordToHost(unsigned int word);
 unsigned short ShortToHost(unsigned short shortword);
 unsigned int WordToMachine(unsigned int word);
 unsigned short ShortToMachine(unsigned short shortword);
+unsigned int SwapWord(unsigned int word);
+unsigned short SwapShort(unsigned short shortword);
 
 #endif // MACHINE_H
@@ -0,0 +1,717 @@
+// mipsblock.cc -- threaded-code engine for the MIPS simulator
+//
+//   An alternative to the one-instruction-at-a-time loop in mipssim.cc,
+//   selected with the "-tc" flag.  User code is run a basic block at a
+//   time: a block is a run of predecoded instructions (see
+//   Machine::FetchInstruction) within one physical page frame, ending
+//   with the delay slot of a branch or jump, with a syscall, or at the
+//   end of the frame.  Within a block, instructions are dispatched
+//   through a table of handler addresses with gcc's computed goto, and
+//   pending interrupts are only checked once the whole block has run.
+//
+//   Each handler does exactly what the matching case in
+//   Machine::OneInstruction does, including the delayed load and
+//   the branch delay slot bookkeeping, and the clock still advances by
+//   UserTick per instruction.  A block is cut short at the instruction
+//   after which the next interrupt could be due (see
+//   Interrupt::TicksUntilDue), so interrupts happen at exactly the same
+//   time as with the reference loop, and the two engines give the same
+//   results, even with a random timer (-rs).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "machine.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// EndsBlock
+// 	Return TRUE if a basic block must end after "instr" -- that is,
+//	if it is a branch or jump (once its delay slot has been added), or
+//	an instruction that always traps to the kernel.
+//----------------------------------------------------------------------
+
+static bool
+EndsBlock(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_SYSCALL:
+      case OP_RES:
+      case OP_UNIMP:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+static bool
+IsBranch(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ:
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+      case OP_BNE:
+      case OP_J:
+      case OP_JAL:
+      case OP_JALR:
+      case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunThreaded
+// 	Simulate the execution of a user-level program a basic block at
+//	a time.  Called by Machine::Run; returns only when the thread is
+//	moved to another CPU.
+//
+//	We only start a block when the next instruction follows the
+//	current one (that is, we are not in a branch delay slot, as we
+//	can be after an exception or if a branch is the last word of a
+//	page frame); otherwise we take a single step with OneInstruction.
+//----------------------------------------------------------------------
+
+void
+Machine::RunThreaded()
+{
+    Instruction *instr = new Instruction;  // storage for single steps
+    ExceptionType exception;
+    int pc, physAddr, slot, limit, count;
+    int planned = 0, i;		// for the profiler
+
+    for (;;) {
+	pc = registers[PCReg];
+	if (registers[NextPCReg] != pc + 4) {
+	    OneInstruction(instr);
+	    interrupt->OneTick();
+	    if (machine != this)	// moved to another CPU
+		break;
+	    continue;
+	}
+	exception = CachedTranslate(pc, &physAddr, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, pc);
+	    interrupt->OneTick();
+	    if (machine != this)
+		break;
+	    continue;
+	}
+	// run no further than the instruction after which an interrupt
+	// might be due, so that it is not delayed
+	limit = (interrupt->TicksUntilDue() + UserTick - 1) / UserTick;
+	if (limit < 1)
+	    limit = 1;
+	slot = physAddr / 4;
+	if (profiler != NULL) {
+	    // count the instructions before running them, as an exit
+	    // system call never returns; take back any not run later
+	    if (blockLength[slot] == 0)
+		BuildBlock(slot);
+	    planned = (limit < blockLength[slot]) ? limit : blockLength[slot];
+	    for (i = 0; i < planned; i++)
+		profiler->Count(pc + i * 4, &decodeCache[slot + i], 1);
+	}
+	blockStartTicks = stats->totalTicks;
+	count = ExecuteBlock(slot, limit);
+	if (profiler != NULL)
+	    for (i = count; i < planned; i++)
+		profiler->Count(pc + i * 4, &decodeCache[slot + i], -1);
+	if (blockStartTicks != NotInBlock)	// no exception; there was
+	    interrupt->SkipChecks(count - 1);	// nothing due after the
+	blockStartTicks = NotInBlock;		// other instructions
+	interrupt->CheckPending();
+	if (machine != this)
+	    break;
+    }
+    delete instr;
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+// 	Find the basic block starting at word "slot" of physical memory,
+//	decoding its instructions if need be.  The length of the block is
+//	remembered in "blockLength" until the frame is invalidated.
+//
+//	Returns the number of instructions in the block.
+//----------------------------------------------------------------------
+
+int
+Machine::BuildBlock(int slot)
+{
+    int frameEnd = (slot * 4 / PageSize + 1) * PageSize / 4;
+    int i;
+
+    for (i = slot; i < frameEnd; i++) {
+	if (!decodeValid[i])
+	    DecodeSlot(i);
+	if (EndsBlock(&decodeCache[i]))
+	    break;
+	if (IsBranch(&decodeCache[i])) {
+	    if (i + 1 < frameEnd) {	// include the delay slot
+		i++;
+		if (!decodeValid[i])
+		    DecodeSlot(i);
+	    }
+	    break;
+	}
+    }
+    if (i == frameEnd)			// ran off the end of the frame
+	i--;
+    blockLength[slot] = i - slot + 1;
+    return blockLength[slot];
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteBlock
+// 	Run the basic block starting at word "slot" of physical memory,
+//	but no more than "limit" instructions of it.  The caller has
+//	already translated the PC to find "slot", and has checked that we
+//	are not in a branch delay slot.
+//
+//	We stop early if an instruction raises an exception (after which
+//	the kernel may have changed anything at all), or if a store
+//	overwrites the block.  Either way, the registers always hold the
+//	state after the last instruction run, just as with OneInstruction.
+//
+//	Returns the number of instructions run.
+//----------------------------------------------------------------------
+
+// Finish an instruction: do any delayed load, advance the program
+// counters and the clock, and go on to the next instruction in the
+// block, if there is one.
+#define NEXT 								\
+    registers[registers[LoadReg]] = registers[LoadValueReg];		\
+    registers[LoadReg] = nextLoadReg;					\
+    registers[LoadValueReg] = nextLoadValue;				\
+    registers[0] = 0;							\
+    registers[PrevPCReg] = registers[PCReg];				\
+    registers[PCReg] = registers[NextPCReg];				\
+    registers[NextPCReg] = pcAfter;					\
+    stats->totalTicks += UserTick;					\
+    stats->userTicks += UserTick;					\
+    if (++instr == end)							\
+	return instr - start;						\
+    pcAfter = registers[NextPCReg] + 4;					\
+    nextLoadReg = 0;							\
+    nextLoadValue = 0;							\
+    goto *handlers[(int) instr->opCode]
+
+// Charge the last instruction its tick and leave the block (after an
+// exception, or when the block has been overwritten).
+#define STOP 							\
+    stats->totalTicks += UserTick;					\
+    stats->userTicks += UserTick;					\
+    return instr - start + 1
+
+int
+Machine::ExecuteBlock(int slot, int limit)
+{
+    // Handler for each opCode (see machine.h); gaps in the numbering
+    // go to "bad".
+    static void *handlers[MaxOpcode + 1] = {
+	&&bad,	   &&op_add,   &&op_addi,  &&op_addiu, 	// 0 - 3
+	&&op_addu, &&op_and,   &&op_andi,  &&op_beq,	// 4 - 7
+	&&op_bgez, &&op_bgezal, &&op_bgtz, &&op_blez,	// 8 - 11
+	&&op_bltz, &&op_bltzal, &&op_bne,  &&bad,	// 12 - 15
+	&&op_div,  &&op_divu,  &&op_j,	   &&op_jal,	// 16 - 19
+	&&op_jalr, &&op_jr,    &&op_lb,	   &&op_lbu,	// 20 - 23
+	&&op_lh,   &&op_lhu,   &&op_lui,   &&op_lw,	// 24 - 27
+	&&op_lwl,  &&op_lwr,   &&bad,	   &&op_mfhi,	// 28 - 31
+	&&op_mflo, &&bad,      &&op_mthi,  &&op_mtlo,	// 32 - 35
+	&&op_mult, &&op_multu, &&op_nor,   &&op_or,	// 36 - 39
+	&&op_ori,  &&bad,      &&op_sb,	   &&op_sh,	// 40 - 43 (41 = RFE)
+	&&op_sll,  &&op_sllv,  &&op_slt,   &&op_slti,	// 44 - 47
+	&&op_sltiu, &&op_sltu, &&op_sra,   &&op_srav,	// 48 - 51
+	&&op_srl,  &&op_srlv,  &&op_sub,   &&op_subu,	// 52 - 55
+	&&op_sw,   &&op_swl,   &&op_swr,   &&op_xor,	// 56 - 59
+	&&op_xori, &&op_syscall, &&op_illegal, &&op_illegal // 60 - 63
+    };
+
+    Instruction *start = &decodeCache[slot];
+    Instruction *instr = start;
+    Instruction *end;
+    int pcAfter, nextLoadReg, nextLoadValue;
+    int sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+
+    if (blockLength[slot] == 0)
+	BuildBlock(slot);
+    if (limit < blockLength[slot])
+	end = start + limit;
+    else
+	end = start + blockLength[slot];
+
+    pcAfter = registers[NextPCReg] + 4;
+    nextLoadReg = 0;
+    nextLoadValue = 0;
+    goto *handlers[(int) instr->opCode];
+
+  op_add:
+    sum = registers[(int) instr->rs] + registers[(int) instr->rt];
+    if (!((registers[(int) instr->rs] ^ registers[(int) instr->rt])
+		& SIGN_BIT) &&
+	((registers[(int) instr->rs] ^ sum) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	STOP;
+    }
+    registers[(int) instr->rd] = sum;
+    NEXT;
+
+  op_addi:
+    sum = registers[(int) instr->rs] + instr->extra;
+    if (!((registers[(int) instr->rs] ^ instr->extra) & SIGN_BIT) &&
+	((instr->extra ^ sum) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	STOP;
+    }
+    registers[(int) instr->rt] = sum;
+    NEXT;
+
+  op_addiu:
+    registers[(int) instr->rt] = registers[(int) instr->rs] + instr->extra;
+    NEXT;
+
+  op_addu:
+    registers[(int) instr->rd] = registers[(int) instr->rs] +
+	registers[(int) instr->rt];
+    NEXT;
+
+  op_and:
+    registers[(int) instr->rd] = registers[(int) instr->rs] &
+	registers[(int) instr->rt];
+    NEXT;
+
+  op_andi:
+    registers[(int) instr->rt] = registers[(int) instr->rs] &
+	(instr->extra & 0xffff);
+    NEXT;
+
+  op_beq:
+    if (registers[(int) instr->rs] == registers[(int) instr->rt])
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_bgezal:
+    registers[R31] = registers[NextPCReg] + 4;
+  op_bgez:
+    if (!(registers[(int) instr->rs] & SIGN_BIT))
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_bgtz:
+    if (registers[(int) instr->rs] > 0)
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_blez:
+    if (registers[(int) instr->rs] <= 0)
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_bltzal:
+    registers[R31] = registers[NextPCReg] + 4;
+  op_bltz:
+    if (registers[(int) instr->rs] & SIGN_BIT)
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_bne:
+    if (registers[(int) instr->rs] != registers[(int) instr->rt])
+	pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+    NEXT;
+
+  op_div:
+    if (registers[(int) instr->rt] == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	registers[LoReg] =  registers[(int) instr->rs] /
+	    registers[(int) instr->rt];
+	registers[HiReg] = registers[(int) instr->rs] %
+	    registers[(int) instr->rt];
+    }
+    NEXT;
+
+  op_divu:
+    rs = (unsigned int) registers[(int) instr->rs];
+    rt = (unsigned int) registers[(int) instr->rt];
+    if (rt == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	tmp = rs / rt;
+	registers[LoReg] = (int) tmp;
+	tmp = rs % rt;
+	registers[HiReg] = (int) tmp;
+    }
+    NEXT;
+
+  op_jal:
+    registers[R31] = registers[NextPCReg] + 4;
+  op_j:
+    pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
+    NEXT;
+
+  op_jalr:
+    registers[(int) instr->rd] = registers[NextPCReg] + 4;
+  op_jr:
+    pcAfter = registers[(int) instr->rs];
+    NEXT;
+
+  op_lb:
+  op_lbu:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (!ReadMemory<FALSE>(tmp, 1, &value)) {
+	STOP;
+    }
+    if ((value & 0x80) && (instr->opCode == OP_LB))
+	value |= 0xffffff00;
+    else
+	value &= 0xff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT;
+
+  op_lh:
+  op_lhu:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (tmp & 0x1) {
+	RaiseException(AddressErrorException, tmp);
+	STOP;
+    }
+    if (!ReadMemory<FALSE>(tmp, 2, &value)) {
+	STOP;
+    }
+    if ((value & 0x8000) && (instr->opCode == OP_LH))
+	value |= 0xffff0000;
+    else
+	value &= 0xffff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT;
+
+  op_lui:
+    registers[(int) instr->rt] = instr->extra << 16;
+    NEXT;
+
+  op_lw:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (tmp & 0x3) {
+	RaiseException(AddressErrorException, tmp);
+	STOP;
+    }
+    if (!ReadMemory<FALSE>(tmp, 4, &value)) {
+	STOP;
+    }
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT;
+
+  op_lwl:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see OneInstruction
+    if (!ReadMemory<FALSE>(tmp, 4, &value)) {
+	STOP;
+    }
+    if (registers[LoadReg] == instr->rt)
+	nextLoadValue = registers[LoadValueReg];
+    else
+	nextLoadValue = registers[(int) instr->rt];
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = value;
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
+	break;
+      case 3:
+	nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT;
+
+  op_lwr:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see OneInstruction
+    if (!ReadMemory<FALSE>(tmp, 4, &value)) {
+	STOP;
+    }
+    if (registers[LoadReg] == instr->rt)
+	nextLoadValue = registers[LoadValueReg];
+    else
+	nextLoadValue = registers[(int) instr->rt];
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = (nextLoadValue & 0xffffff00) |
+	    ((value >> 24) & 0xff);
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xffff0000) |
+	    ((value >> 16) & 0xffff);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xff000000)
+	    | ((value >> 8) & 0xffffff);
+	break;
+      case 3:
+	nextLoadValue = value;
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT;
+
+  op_mfhi:
+    registers[(int) instr->rd] = registers[HiReg];
+    NEXT;
+
+  op_mflo:
+    registers[(int) instr->rd] = registers[LoReg];
+    NEXT;
+
+  op_mthi:
+    registers[HiReg] = registers[(int) instr->rs];
+    NEXT;
+
+  op_mtlo:
+    registers[LoReg] = registers[(int) instr->rs];
+    NEXT;
+
+  op_mult:
+    Mult(registers[(int) instr->rs], registers[(int) instr->rt], TRUE,
+	 &registers[HiReg], &registers[LoReg]);
+    NEXT;
+
+  op_multu:
+    Mult(registers[(int) instr->rs], registers[(int) instr->rt], FALSE,
+	 &registers[HiReg], &registers[LoReg]);
+    NEXT;
+
+  op_nor:
+    registers[(int) instr->rd] = ~(registers[(int) instr->rs] |
+	registers[(int) instr->rt]);
+    NEXT;
+
+  op_or:
+    // NOTE: the same as OneInstruction, so the two engines agree
+    registers[(int) instr->rd] = registers[(int) instr->rs] |
+	registers[(int) instr->rs];
+    NEXT;
+
+  op_ori:
+    registers[(int) instr->rt] = registers[(int) instr->rs] |
+	(instr->extra & 0xffff);
+    NEXT;
+
+  op_sb:
+    if (!WriteMemory<FALSE>((unsigned)
+	    (registers[(int) instr->rs] + instr->extra), 1,
+	    registers[(int) instr->rt])) {
+	STOP;
+    }
+    if (!decodeValid[slot])
+	goto modified;
+    NEXT;
+
+  op_sh:
+    if (!WriteMemory<FALSE>((unsigned)
+	    (registers[(int) instr->rs] + instr->extra), 2,
+	    registers[(int) instr->rt])) {
+	STOP;
+    }
+    if (!decodeValid[slot])
+	goto modified;
+    NEXT;
+
+  op_sll:
+    registers[(int) instr->rd] = registers[(int) instr->rt] << instr->extra;
+    NEXT;
+
+  op_sllv:
+    registers[(int) instr->rd] = registers[(int) instr->rt] <<
+	(registers[(int) instr->rs] & 0x1f);
+    NEXT;
+
+  op_slt:
+    if (registers[(int) instr->rs] < registers[(int) instr->rt])
+	registers[(int) instr->rd] = 1;
+    else
+	registers[(int) instr->rd] = 0;
+    NEXT;
+
+  op_slti:
+    if (registers[(int) instr->rs] < instr->extra)
+	registers[(int) instr->rt] = 1;
+    else
+	registers[(int) instr->rt] = 0;
+    NEXT;
+
+  op_sltiu:
+    rs = registers[(int) instr->rs];
+    imm = instr->extra;
+    if (rs < imm)
+	registers[(int) instr->rt] = 1;
+    else
+	registers[(int) instr->rt] = 0;
+    NEXT;
+
+  op_sltu:
+    rs = registers[(int) instr->rs];
+    rt = registers[(int) instr->rt];
+    if (rs < rt)
+	registers[(int) instr->rd] = 1;
+    else
+	registers[(int) instr->rd] = 0;
+    NEXT;
+
+  op_sra:
+    registers[(int) instr->rd] = registers[(int) instr->rt] >> instr->extra;
+    NEXT;
+
+  op_srav:
+    registers[(int) instr->rd] = registers[(int) instr->rt] >>
+	(registers[(int) instr->rs] & 0x1f);
+    NEXT;
+
+  op_srl:
+    tmp = registers[(int) instr->rt];
+    tmp >>= instr->extra;
+    registers[(int) instr->rd] = tmp;
+    NEXT;
+
+  op_srlv:
+    tmp = registers[(int) instr->rt];
+    tmp >>= (registers[(int) instr->rs] & 0x1f);
+    registers[(int) instr->rd] = tmp;
+    NEXT;
+
+  op_sub:
+    diff = registers[(int) instr->rs] - registers[(int) instr->rt];
+    if (((registers[(int) instr->rs] ^ registers[(int) instr->rt])
+		& SIGN_BIT) &&
+	((registers[(int) instr->rs] ^ diff) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	STOP;
+    }
+    registers[(int) instr->rd] = diff;
+    NEXT;
+
+  op_subu:
+    registers[(int) instr->rd] = registers[(int) instr->rs] -
+	registers[(int) instr->rt];
+    NEXT;
+
+  op_sw:
+    if (!WriteMemory<FALSE>((unsigned)
+	    (registers[(int) instr->rs] + instr->extra), 4,
+	    registers[(int) instr->rt])) {
+	STOP;
+    }
+    if (!decodeValid[slot])
+	goto modified;
+    NEXT;
+
+  op_swl:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see OneInstruction
+    if (!ReadMemory<FALSE>((tmp & ~0x3), 4, &value)) {
+	STOP;
+    }
+    switch (tmp & 0x3) {
+      case 0:
+	value = registers[(int) instr->rt];
+	break;
+      case 1:
+	value = (value & 0xff000000) | ((registers[(int) instr->rt] >> 8) &
+					0xffffff);
+	break;
+      case 2:
+	value = (value & 0xffff0000) | ((registers[(int) instr->rt] >> 16) &
+					0xffff);
+	break;
+      case 3:
+	value = (value & 0xffffff00) | ((registers[(int) instr->rt] >> 24) &
+					0xff);
+	break;
+    }
+    if (!WriteMemory<FALSE>((tmp & ~0x3), 4, value)) {
+	STOP;
+    }
+    if (!decodeValid[slot])
+	goto modified;
+    NEXT;
+
+  op_swr:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see OneInstruction
+    if (!ReadMemory<FALSE>((tmp & ~0x3), 4, &value)) {
+	STOP;
+    }
+    switch (tmp & 0x3) {
+      case 0:
+	value = (value & 0xffffff) | (registers[(int) instr->rt] << 24);
+	break;
+      case 1:
+	value = (value & 0xffff) | (registers[(int) instr->rt] << 16);
+	break;
+      case 2:
+	value = (value & 0xff) | (registers[(int) instr->rt] << 8);
+	break;
+      case 3:
+	value = registers[(int) instr->rt];
+	break;
+    }
+    if (!WriteMemory<FALSE>((tmp & ~0x3), 4, value)) {
+	STOP;
+    }
+    if (!decodeValid[slot])
+	goto modified;
+    NEXT;
+
+  op_syscall:
+    RaiseException(SyscallException, 0);
+    STOP;
+
+  op_xor:
+    registers[(int) instr->rd] = registers[(int) instr->rs] ^
+	registers[(int) instr->rt];
+    NEXT;
+
+  op_xori:
+    registers[(int) instr->rt] = registers[(int) instr->rs] ^
+	(instr->extra & 0xffff);
+    NEXT;
+
+  op_illegal:
+    RaiseException(IllegalInstrException, 0);
+    STOP;
+
+  modified:
+    // a store overwrote the frame holding this block; finish the store
+    // and go back to RunThreaded to decode the new contents
+    registers[registers[LoadReg]] = registers[LoadValueReg];
+    registers[LoadReg] = nextLoadReg;
+    registers[LoadValueReg] = nextLoadValue;
+    registers[0] = 0;
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] = pcAfter;
+    STOP;
+
+  bad:
+    ASSERT(FALSE);
+    return 0;
+}
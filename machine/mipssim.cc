@@ -16,8 +16,6 @@
 #include "mipssim.h"
 #include "system.h"
 
-static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
-
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
@@ -25,23 +23,72 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	On a multiprocessor, the kernel may move the thread to another
+//	CPU (that is, change "machine") whenever it gets control; we then 
+//	carry on with the registers of the new CPU.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
+    Machine *cpu;
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+    for (cpu = this; ; cpu = machine)
+	cpu->RunUntilMoved();		// never returns on a uniprocessor
+}
+
+//----------------------------------------------------------------------
+// Machine::RunUntilMoved
+// 	Simulate the execution of a user-level program on this CPU, until 
+//	the thread running it is moved to another CPU.
+//
+//	The threaded-code engine charges UserTick for every instruction,
+//	so with the cost model on, the one-at-a-time loop is used.
+//----------------------------------------------------------------------
+
+void
+Machine::RunUntilMoved()
+{
+    if (threadedCode && !instrumented && !DebugIsEnabled('i') 
+			&& (tlb == NULL) && !ModelCosts)
+	RunThreaded();
+    else if (instrumented)
+	RunLoop<TRUE>();
+    else
+	RunLoop<FALSE>();
+}
+
+//----------------------------------------------------------------------
+// Machine::RunLoop
+// 	Simulate the execution of a user-level program, one instruction
+//	at a time, until the thread is moved to another CPU.
+//
+//	Machine::RunUntilMoved picks the version to use, the same for
+//	every CPU.  With "Instrumented" FALSE, the compiler leaves out the 
+//	single step checks and the 'm' and 'a' debug messages, so that
+//	they cost nothing when they are not wanted.
+//----------------------------------------------------------------------
+
+template <bool Instrumented> void
+Machine::RunLoop()
+{
+    Instruction *instr = new Instruction;  // storage for decoded instruction
+
     for (;;) {
-        OneInstruction(instr);
+        Execute<Instrumented>(instr);
 	interrupt->OneTick();
-	if (singleStep && (runUntilTime <= stats->totalTicks))
+	if (machine != this)		// moved to another CPU
+	    break;
+	if (Instrumented && singleStep 
+			&& (runUntilTime <= stats->totalTicks))
 	  	Debugger();
     }
+    delete instr;
 }
 
 
@@ -93,18 +140,36 @@ TypeToReg(RegType reg, Instruction *instr)
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    int raw;
+    if (instrumented)
+	Execute<TRUE>(instr);
+    else
+	Execute<FALSE>(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::Execute
+// 	Execute one instruction, as OneInstruction.  If "Instrumented"
+//	is FALSE, there is no 'm' or 'a' debugging output.
+//----------------------------------------------------------------------
+
+template <bool Instrumented> void
+Machine::Execute(Instruction *instr)
+{
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!FetchInstruction(registers[PCReg], instr))
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
-
-    if (DebugIsEnabled('m')) {
+#ifdef USER_PROGRAM
+    if (profiler != NULL)
+	profiler->Count(registers[PCReg], instr, 1);
+#endif
+    if (ModelCosts)
+	ChargeCost(instr);
+
+    if (Instrumented && DebugIsEnabled('m')) {
        struct OpString *str = &opStrings[instr->opCode];
 
        ASSERT(instr->opCode <= MaxOpcode);
@@ -231,7 +296,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LB:
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
+	if (!ReadMemory<Instrumented>(tmp, 1, &value))
 	    return;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
@@ -249,7 +314,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 2, &value))
+	if (!ReadMemory<Instrumented>(tmp, 2, &value))
 	    return;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
@@ -261,7 +326,8 @@ Machine::OneInstruction(Instruction *instr)
 	break;
       	
       case OP_LUI:
-	DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
+	if (Instrumented)
+	    DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
 	registers[instr->rt] = instr->extra << 16;
 	break;
 	
@@ -271,7 +337,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMemory<Instrumented>(tmp, 4, &value))
 	    return;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
@@ -285,7 +351,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMemory<Instrumented>(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -316,7 +382,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMemory<Instrumented>(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -381,13 +447,13 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SB:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMemory<Instrumented>((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
 	    return;
 	break;
 	
       case OP_SH:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMemory<Instrumented>((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
 	    return;
 	break;
@@ -469,7 +535,7 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SW:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMemory<Instrumented>((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
 	break;
@@ -481,7 +547,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMemory<Instrumented>((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -500,7 +566,7 @@ Machine::OneInstruction(Instruction *instr)
 					    0xff);
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMemory<Instrumented>((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
@@ -511,7 +577,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMemory<Instrumented>((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -527,7 +593,7 @@ Machine::OneInstruction(Instruction *instr)
 	    value = registers[instr->rt];
 	    break;
 	} // end of switch (tmp & 0x3) 
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMemory<Instrumented>((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
@@ -563,6 +629,58 @@ Machine::OneInstruction(Instruction *instr)
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
 }
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Fetch the instruction at virtual address "addr" and decode it.
+//
+//	Decoding is done at most once per word of physical memory: the
+//	decoded instruction is kept in "decodeCache", indexed by physical 
+//	address, until the page frame holding it is written (see WriteMem
+//	and InvalidateDecodedFrame).  The address is still translated on
+//	every fetch (through the translation cache), so page faults and
+//	the use bit behave as before.
+//
+//	Returns FALSE if the translation failed (the exception has
+//	already been raised).
+//
+//	"addr" -- the virtual address of the instruction
+//	"instr" -- the place to put the decoded instruction
+//----------------------------------------------------------------------
+
+bool
+Machine::FetchInstruction(int addr, Instruction *instr)
+{
+    int physAddr, slot;
+    ExceptionType exception;
+
+    exception = CachedTranslate(addr, &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, addr);
+	return FALSE;
+    }
+    slot = physAddr / 4;
+    if (!decodeValid[slot])
+	DecodeSlot(slot);
+    *instr = decodeCache[slot];
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeSlot
+// 	Decode the word at physical address "slot * 4" into decodeCache.
+//----------------------------------------------------------------------
+
+void
+Machine::DecodeSlot(int slot)
+{
+    decodeCache[slot].value = *(unsigned int *) &mainMemory[slot * 4];
+    if (!hostOrder)
+	decodeCache[slot].value = SwapWord(decodeCache[slot].value);
+    decodeCache[slot].Decode();
+    decodeValid[slot] = TRUE;
+    frameDecoded[slot * 4 / PageSize] = TRUE;
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 // 	Simulate effects of a delayed load.
@@ -631,7 +749,7 @@ Instruction::Decode()
 // 	double-length result of the multiplication.
 //----------------------------------------------------------------------
 
-static void
+void
 Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr)
 {
     if ((a == 0) || (b == 0)) {
@@ -74,12 +74,24 @@ Network::CheckPktAvail()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
+    bool fromLog = (eventLog != NULL) && eventLog->IsReplaying()
+			&& (eventLog->NextEvent(NetworkEvent) >= 0);
+    if (fromLog) {		// take the packets from the log instead,
+	if (eventLog->NextEvent(NetworkEvent) > stats->totalTicks)
+	    return;		// at the logged times
+    } else if (!PollSocket(sock)) // do nothing if no packet to be read
 	return;
 
     // otherwise, read packet in
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    if (fromLog)
+	eventLog->Replay(NetworkEvent, buffer, MaxWireSize);
+    else {
+	ReadFromSocket(sock, buffer, MaxWireSize);
+	if ((eventLog != NULL) && eventLog->IsRecording())
+	    eventLog->Record(NetworkEvent, stats->totalTicks, buffer,
+							MaxWireSize);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
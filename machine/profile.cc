@@ -0,0 +1,168 @@
+// profile.cc
+//	Routines to profile user programs, and to print the profile when
+//	Nachos halts.
+//
+//	There is no symbol table in a NOFF file (coff2noff leaves it
+//	behind), so hot spots are shown by address, with the instruction
+//	disassembled as for the 'm' debug flag.  To make the addresses
+//	easier to find in a listing, each one is also given relative to
+//	the routine it is in, taking the targets of the JAL instructions
+//	that were run, and address 0 (where Start is linked), as the
+//	beginnings of routines.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "opstrings.h"
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Initialize an empty profile.
+//
+//	"addressSpaceSize" -- how many bytes of virtual address space to
+//		keep counts for; the mix of instructions also counts
+//		instructions beyond this.
+//----------------------------------------------------------------------
+
+Profiler::Profiler(int addressSpaceSize)
+{
+    int i;
+
+    numSlots = addressSpaceSize / 4;
+    pcCount = new int[numSlots];
+    pcValue = new unsigned int[numSlots];
+    for (i = 0; i < numSlots; i++) {
+	pcCount[i] = 0;
+	pcValue[i] = 0;
+    }
+    for (i = 0; i < NumOpcodes; i++)
+	opCount[i] = 0;
+    total = 0;
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	De-allocate the profile.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    delete [] pcCount;
+    delete [] pcValue;
+}
+
+//----------------------------------------------------------------------
+// TypeToReg
+// 	Retrieve the register # referred to in an instruction (as in
+//	mipssim.cc).
+//----------------------------------------------------------------------
+
+static int
+TypeToReg(RegType reg, Instruction *instr)
+{
+    switch (reg) {
+      case RS:
+	return instr->rs;
+      case RT:
+	return instr->rt;
+      case RD:
+	return instr->rd;
+      case EXTRA:
+	return instr->extra;
+      default:
+	return -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// PrintMnemonic
+// 	Print the name of an instruction, without its operands, padded
+//	to a fixed width.
+//----------------------------------------------------------------------
+
+static void
+PrintMnemonic(int opCode)
+{
+    const char *s = opStrings[opCode].string;
+    int n;
+
+    for (n = 0; s[n] != '\0' && s[n] != ' '; n++)
+	putchar(s[n]);
+    for (; n < 8; n++)
+	putchar(' ');
+}
+
+//----------------------------------------------------------------------
+// Profiler::Print
+// 	Print the HotSpots most often executed instructions, most
+//	frequent first, and then the number of times each kind of
+//	instruction was executed.
+//----------------------------------------------------------------------
+
+void
+Profiler::Print()
+{
+    int hot[HotSpots];			// most frequent slots, sorted
+    int numHot = 0;
+    bool *isEntry = new bool[numSlots];	// does a routine start here?
+    Instruction instr;
+    struct OpString *str;
+    int i, j, entry;
+
+    if (total == 0) {
+	delete [] isEntry;
+	return;
+    }
+    printf("Profile: %d user instructions\n", total);
+
+    for (i = 0; i < numSlots; i++)
+	isEntry[i] = FALSE;
+    isEntry[0] = TRUE;
+    for (i = 0; i < numSlots; i++) {
+	if (pcCount[i] <= 0)
+	    continue;
+	instr.value = pcValue[i];
+	instr.Decode();
+	if (instr.opCode == OP_JAL && (unsigned) instr.extra <
+						(unsigned) numSlots)
+	    isEntry[instr.extra] = TRUE;
+
+	// keep the HotSpots largest counts, in order
+	if (numHot == HotSpots && pcCount[i] <= pcCount[hot[numHot - 1]])
+	    continue;
+	if (numHot < HotSpots)
+	    numHot++;
+	for (j = numHot - 1; j > 0 && pcCount[hot[j - 1]] < pcCount[i]; j--)
+	    hot[j] = hot[j - 1];
+	hot[j] = i;
+    }
+
+    printf("     count      %%  address  routine+offset    instruction\n");
+    for (i = 0; i < numHot; i++) {
+	for (entry = hot[i]; !isEntry[entry]; entry--)
+	    ;
+	instr.value = pcValue[hot[i]];
+	instr.Decode();
+	str = &opStrings[(int) instr.opCode];
+	printf("%10d %5.1f%%  0x%06x 0x%06x+%-6d  ", pcCount[hot[i]],
+		100.0 * pcCount[hot[i]] / total, hot[i] * 4, entry * 4,
+		(hot[i] - entry) * 4);
+	printf(str->string, TypeToReg(str->args[0], &instr),
+		TypeToReg(str->args[1], &instr),
+		TypeToReg(str->args[2], &instr));
+	printf("\n");
+    }
+    delete [] isEntry;
+
+    printf("Instruction mix:\n");
+    for (i = 0; i < NumOpcodes; i++) {
+	if (opCount[i] == 0)
+	    continue;
+	printf("  ");
+	PrintMnemonic(i);
+	printf("%10d %5.1f%%\n", opCount[i], 100.0 * opCount[i] / total);
+    }
+}
@@ -0,0 +1,73 @@
+// profile.h
+//	Data structures for profiling user programs: how many times the
+//	instruction at each program counter value was executed, and how
+//	many times each kind of instruction was executed.
+//
+//	The counts are kept by the machine emulation as it runs user
+//	instructions (see Machine::OneInstruction and Machine::RunThreaded),
+//	and printed as a table of hot spots when Nachos halts.
+//
+//	Counts are kept by virtual address, and are not separated by
+//	address space; as all user programs are linked at address 0,
+//	several programs run together will share the table.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define NumOpcodes	64	// one more than MaxOpcode, in machine.h
+#define HotSpots	20	// # of program counter values to print
+
+// The following class defines the profile of the user programs run
+// since Nachos started.
+
+class Profiler {
+  public:
+    Profiler(int addressSpaceSize);	// no counts yet; only program
+					// counters below "addressSpaceSize"
+					// are counted one by one
+    ~Profiler();
+
+    void Count(int pc, Instruction *instr, int times);
+					// note that the instruction "instr",
+					// at address "pc", was run "times"
+					// more times (which can be negative,
+					// to take back counts made early)
+    void Print();			// print the hot spots and the mix
+					// of instructions
+
+  private:
+    int numSlots;			// # of words of address space counted
+    int *pcCount;			// # of times each word was executed
+    unsigned int *pcValue;		// the instruction last run there,
+					// to disassemble
+    int opCount[NumOpcodes];		// # of times each opCode was run
+    int total;				// # of instructions run in all
+};
+
+//----------------------------------------------------------------------
+// Profiler::Count
+// 	Called for every user instruction (or run of instructions), so
+//	it must be cheap.
+//----------------------------------------------------------------------
+
+inline void
+Profiler::Count(int pc, Instruction *instr, int times)
+{
+    unsigned int slot = (unsigned) pc / 4;
+
+    if (slot < (unsigned) numSlots) {
+	pcCount[slot] += times;
+	pcValue[slot] = instr->value;
+    }
+    opCount[(int) instr->opCode] += times;
+    total += times;
+}
+
+#endif // PROFILE_H
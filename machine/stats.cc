@@ -22,6 +22,65 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numCountedProcesses = 0;
+    SetProcess(-1);			// "no process" comes first
+    for (int i = 0; i < MaxCPUs; i++)
+	cpuCounters[i].userTicks = cpuCounters[i].systemTicks = 0;
+    numCPUs = 1;
+    cpu = 0;
+    chargedUserTicks = chargedSystemTicks = 0;
+    numCountedThreads = numThreads = 0;
+    allThreads.ticks = allThreads.waitTicks = 0;
+    allThreads.responseTicks = allThreads.dispatches = 0;
+    allThreads.tickets = allThreads.entitledTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Statistics::SetProcess
+// 	Charge the TLB hits, misses and refills, and the instructions run
+//	under the cost model, from now on to process "pid".  Called by the
+//	kernel when it switches address spaces.
+//
+//	"pid" -- the process about to run, or -1 for none
+//----------------------------------------------------------------------
+
+void
+Statistics::SetProcess(int pid)
+{
+    int i;
+
+    for (i = 0; i < numCountedProcesses; i++)
+	if (processCounters[i].pid == pid) {
+	    process = &processCounters[i];
+	    return;
+	}
+    if (numCountedProcesses == MaxCountedProcesses) {
+	process = &processCounters[0];	// out of room
+	return;
+    }
+    process = &processCounters[numCountedProcesses++];
+    process->pid = pid;
+    process->hits = process->misses = process->refills = 0;
+    for (i = 0; i < NumInstrClasses; i++)
+	process->instructions[i] = process->ticks[i] = 0;
+    process->loadStallTicks = process->hiloStallTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Statistics::SetCPU
+// 	Charge the user and system time since the last call to the CPU
+//	that was running, and charge time to CPU "which" from now on.
+//	Called by the kernel when it switches CPUs.
+//----------------------------------------------------------------------
+
+void
+Statistics::SetCPU(int which)
+{
+    cpuCounters[cpu].userTicks += userTicks - chargedUserTicks;
+    cpuCounters[cpu].systemTicks += systemTicks - chargedSystemTicks;
+    chargedUserTicks = userTicks;
+    chargedSystemTicks = systemTicks;
+    cpu = which;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +98,254 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
+    PrintTLB();
+    PrintCosts();
+    PrintCPUs();
+    PrintThreads();
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
+
+//----------------------------------------------------------------------
+// Statistics::PrintTLB
+// 	Print the TLB hits, misses and refills, in total and for each
+//	process.  Nothing is printed if there is no TLB.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintTLB()
+{
+    int hits = 0, misses = 0, refills = 0;
+    ProcessCounters *c;
+    int i;
+
+    for (i = 0; i < numCountedProcesses; i++) {
+	hits += processCounters[i].hits;
+	misses += processCounters[i].misses;
+	refills += processCounters[i].refills;
+    }
+    if (hits + misses == 0)
+	return;
+    printf("TLB: hits %d, misses %d, refills %d, hit rate %.2f%%\n", 
+	hits, misses, refills, 100.0 * hits / (hits + misses));
+    for (i = 0; i < numCountedProcesses; i++) {
+	c = &processCounters[i];
+	if (c->hits + c->misses == 0)
+	    continue;
+	if (c->pid == -1)
+	    printf("  no process: ");
+	else
+	    printf("  pid %d: ", c->pid);
+	printf("hits %d, misses %d, refills %d, hit rate %.2f%%\n", 
+	    c->hits, c->misses, c->refills, 
+	    100.0 * c->hits / (c->hits + c->misses));
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintCosts
+// 	Print what the cost model found: the mix of instructions run, and
+//	the share of the time each kind took, in total; then the same for
+//	each process, more briefly.  CPI is ticks per instruction, with a
+//	tick being a cycle.  Nothing is printed if the cost model is off.
+//----------------------------------------------------------------------
+
+static const char *instrClassNames[NumInstrClasses] =
+	{ "alu", "load", "store", "mult", "div", "branch", "syscall" };
+
+void
+Statistics::PrintCosts()
+{
+    ProcessCounters all, *c;
+    int instructions, ticks, stalls;
+    int i, j;
+
+    all.loadStallTicks = all.hiloStallTicks = 0;
+    for (j = 0; j < NumInstrClasses; j++)
+	all.instructions[j] = all.ticks[j] = 0;
+    for (i = 0; i < numCountedProcesses; i++) {
+	c = &processCounters[i];
+	for (j = 0; j < NumInstrClasses; j++) {
+	    all.instructions[j] += c->instructions[j];
+	    all.ticks[j] += c->ticks[j];
+	}
+	all.loadStallTicks += c->loadStallTicks;
+	all.hiloStallTicks += c->hiloStallTicks;
+    }
+    instructions = ticks = 0;
+    for (j = 0; j < NumInstrClasses; j++) {
+	instructions += all.instructions[j];
+	ticks += all.ticks[j];
+    }
+    if (instructions == 0)
+	return;
+    stalls = all.loadStallTicks + all.hiloStallTicks;
+    ticks += stalls;
+    printf("Costs: instructions %d, ticks %d, CPI %.2f\n", instructions,
+	ticks, (double) ticks / instructions);
+    for (j = 0; j < NumInstrClasses; j++)
+	if (all.instructions[j] > 0)
+	    printf("  %-8s %5.2f%% of instructions, %5.2f%% of ticks\n", 
+		instrClassNames[j], 100.0 * all.instructions[j] / instructions,
+		100.0 * all.ticks[j] / ticks);
+    printf("  stalls   load use %d, mult/div %d, %5.2f%% of ticks\n",
+	all.loadStallTicks, all.hiloStallTicks, 100.0 * stalls / ticks);
+    for (i = 0; i < numCountedProcesses; i++) {
+	c = &processCounters[i];
+	instructions = ticks = 0;
+	for (j = 0; j < NumInstrClasses; j++) {
+	    instructions += c->instructions[j];
+	    ticks += c->ticks[j];
+	}
+	if (instructions == 0)
+	    continue;
+	stalls = c->loadStallTicks + c->hiloStallTicks;
+	ticks += stalls;
+	if (c->pid == -1)
+	    printf("  no process: ");
+	else
+	    printf("  pid %d: ", c->pid);
+	printf("instructions %d, ticks %d, CPI %.2f, load/store %.2f%%, "
+	    "mult/div %.2f%%, branch %.2f%%, stalls %.2f%%\n", 
+	    instructions, ticks, (double) ticks / instructions,
+	    100.0 * (c->ticks[LoadInstr] + c->ticks[StoreInstr]) / ticks,
+	    100.0 * (c->ticks[MultInstr] + c->ticks[DivInstr]) / ticks,
+	    100.0 * c->ticks[BranchInstr] / ticks, 100.0 * stalls / ticks);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintCPUs
+// 	Print how long each CPU of a multiprocessor was busy, and how
+//	many CPUs were busy on average.  As the CPUs run at the same time,
+//	their user and system time together can be more than the total.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintCPUs()
+{
+    CPUCounters *c;
+    int busy = 0;
+    int i;
+
+    if (numCPUs == 1)
+	return;
+    SetCPU(cpu);			// bring the running CPU up to date
+    for (i = 0; i < numCPUs; i++) {
+	c = &cpuCounters[i];
+	printf("CPU %d: system %d, user %d, busy %.2f%%\n", i, 
+	    c->systemTicks, c->userTicks, 
+	    100.0 * (c->systemTicks + c->userTicks) / totalTicks);
+	busy += c->systemTicks + c->userTicks;
+    }
+    printf("CPUs busy on average: %.2f\n", (double) busy / totalTicks);
+}
+
+//----------------------------------------------------------------------
+// Statistics::CountThread
+// 	Keep the times of a thread that has finished, to be printed when
+//	Nachos halts.  Called by the scheduler, if it is reporting them.
+//
+//	"name" -- the thread's name
+//	"ticks" -- how long it ran
+//	"waitTicks" -- how long it waited on the ready list
+//	"responseTicks" -- how long it waited before it first ran
+//	"dispatches" -- how many times it was given the CPU
+//	"tickets" -- its tickets under stride scheduling, or 0
+//	"entitledTicks" -- how long its tickets entitled it to run, while
+//		it was competing for the CPU
+//----------------------------------------------------------------------
+
+void
+Statistics::CountThread(char *name, int ticks, int waitTicks, 
+			int responseTicks, int dispatches, 
+			int tickets, int entitledTicks)
+{
+    ThreadCounters *c;
+
+    allThreads.ticks += ticks;
+    allThreads.waitTicks += waitTicks;
+    allThreads.responseTicks += responseTicks;
+    allThreads.dispatches += dispatches;
+    allThreads.tickets += tickets;
+    allThreads.entitledTicks += entitledTicks;
+    numThreads++;
+    if (numCountedThreads == MaxCountedThreads)
+	return;				// out of room
+    c = &threadCounters[numCountedThreads++];
+    strncpy(c->name, name, sizeof(c->name) - 1);
+    c->name[sizeof(c->name) - 1] = '\0';
+    c->ticks = ticks;
+    c->waitTicks = waitTicks;
+    c->responseTicks = responseTicks;
+    c->dispatches = dispatches;
+    c->tickets = tickets;
+    c->entitledTicks = entitledTicks;
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintThreads
+// 	Print the times kept by CountThread for each thread, and their
+//	averages.  Nothing is printed if no thread was counted.
+//
+//	Under stride scheduling, each thread's share of the time run by
+//	all of them is printed too, beside the share its tickets asked
+//	for: its part of the time they were all entitled to.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintThreads()
+{
+    ThreadCounters *c;
+
+    if (numThreads == 0)
+	return;
+    printf("Threads: %d finished, average ran %d, waited %d, response %d\n",
+	numThreads, allThreads.ticks / numThreads, 
+	allThreads.waitTicks / numThreads, 
+	allThreads.responseTicks / numThreads);
+    for (int i = 0; i < numCountedThreads; i++) {
+	c = &threadCounters[i];
+	printf("  %s: ran %d, waited %d, response %d, dispatched %d\n",
+	    c->name, c->ticks, c->waitTicks, c->responseTicks, 
+	    c->dispatches);
+	if (c->tickets > 0 && allThreads.ticks > 0 
+				&& allThreads.entitledTicks > 0)
+	    printf("    %d tickets: asked for %.1f%% of the CPU, got %.1f%%\n",
+		c->tickets, 
+		100.0 * c->entitledTicks / allThreads.entitledTicks,
+		100.0 * c->ticks / allThreads.ticks);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::Checkpoint
+// 	Write all the statistics to the open UNIX file "fd", for a
+//	checkpoint of the simulation.
+//----------------------------------------------------------------------
+
+void
+Statistics::Checkpoint(int fd)
+{
+    int current = process - processCounters;
+
+    WriteFile(fd, (char *) this, sizeof(Statistics));
+    WriteFile(fd, (char *) &current, sizeof(int));
+}
+
+//----------------------------------------------------------------------
+// Statistics::Restore
+// 	Read back the statistics written by Checkpoint.  "process" is a
+//	pointer, so it is saved as an index instead.
+//----------------------------------------------------------------------
+
+void
+Statistics::Restore(int fd)
+{
+    int current;
+
+    Read(fd, (char *) this, sizeof(Statistics));
+    Read(fd, (char *) &current, sizeof(int));
+    ASSERT((current >= 0) && (current < MaxCountedProcesses));
+    process = &processCounters[current];
+}
@@ -13,6 +13,61 @@
 
 #include "copyright.h"
 
+// The kinds of user instructions, as the cost model (-cost) charges
+// for them (see machine/costmodel.cc).
+
+enum InstrClass { ALUInstr, LoadInstr, StoreInstr, MultInstr, DivInstr,
+		  BranchInstr, SyscallInstr, NumInstrClasses };
+
+// The following class defines the statistics kept for each process 
+// (see Statistics::SetProcess): its TLB events, and, with the cost 
+// model, the instructions it ran and the time they took.
+
+class ProcessCounters {
+  public:
+    int pid;			// the process, or -1 for none
+    int hits;			// # of translations found in the TLB
+    int misses;			// # of translations not found
+    int refills;		// # of TLB entries loaded by the kernel
+    int instructions[NumInstrClasses];	// # of instructions of each kind
+    int ticks[NumInstrClasses];	// time they took, not counting stalls
+    int loadStallTicks;		// time lost waiting for a load
+    int hiloStallTicks;		// time lost waiting for a mult or div
+};
+
+#define MaxCountedProcesses	128	// after this many, events are 
+					// charged to "no process"
+
+// The following class defines the time kept for each simulated CPU
+// of a multiprocessor (see Statistics::SetCPU).
+
+class CPUCounters {
+  public:
+    int userTicks;		// time spent running user code
+    int systemTicks;		// time spent running kernel code
+};
+
+#define MaxCPUs		8	// most CPUs a multiprocessor can have
+
+// The following class defines the times kept for each thread that has
+// finished, when the scheduler is asked to report them (see
+// Statistics::CountThread).
+
+class ThreadCounters {
+  public:
+    char name[20];		// the thread's name, maybe cut short
+    int ticks;			// time it ran
+    int waitTicks;		// time it spent ready, waiting to run
+    int responseTicks;		// time from first being ready to first
+				// running
+    int dispatches;		// # of times it was given the CPU
+    int tickets;		// under stride scheduling, its tickets
+    int entitledTicks;		// and the time they entitled it to run
+};
+
+#define MaxCountedThreads	128	// after this many, only the totals
+					// are kept
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -26,7 +81,8 @@ class Statistics {
     int systemTicks;	 	// Time spent executing system code
     int userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
-				// user instructions executed)
+				// user instructions executed,
+				// unless the cost model is on)
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
@@ -36,9 +92,42 @@ class Statistics {
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    ProcessCounters *process;	// where to count events for the
+				// current process
+    ProcessCounters processCounters[MaxCountedProcesses];
+    int numCountedProcesses;	// # of processes with statistics,
+				// counting "no process" first
+
+    CPUCounters cpuCounters[MaxCPUs];
+    int numCPUs;		// # of simulated CPUs (1 unless -cpus)
+    int cpu;			// the CPU running now
+    int chargedUserTicks;	// userTicks and systemTicks, when they
+    int chargedSystemTicks;	// were last charged to a CPU
+
+    ThreadCounters threadCounters[MaxCountedThreads];
+    int numCountedThreads;	// # of threads with their own statistics
+    ThreadCounters allThreads;	// the totals over every thread counted
+    int numThreads;		// # of threads counted in allThreads
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+    void SetProcess(int pid);	// charge TLB events and instructions to
+				// process "pid" from now on
+    void PrintTLB();		// print the TLB statistics, if any
+    void PrintCosts();		// print the instruction mix and CPI, if
+				// the cost model is on
+    void SetCPU(int which);	// charge time to CPU "which" from now on
+    void PrintCPUs();		// print the time each CPU was busy, if
+				// there is more than one
+    void CountThread(char *name, int ticks, int waitTicks,
+		     int responseTicks, int dispatches, 
+		     int tickets, int entitledTicks);
+				// keep the times of a finished thread
+    void PrintThreads();	// print them, if any
+
+    void Checkpoint(int fd);	// save the statistics to a UNIX file
+    void Restore(int fd);	// and read them back
 };
 
 // Constants used to reflect the relative time an operation would
@@ -50,6 +139,7 @@ class Statistics {
 // these time constants are none too exact.
 
 #define UserTick 	1	// advance for each user-level instruction 
+				// (unless the cost model is on)
 #define SystemTick 	10 	// advance each time interrupts are enabled
 #define RotationTime 	500 	// time disk takes to rotate one sector
 #define SeekTime 	500    	// time disk takes to seek past one track
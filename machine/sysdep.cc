@@ -60,7 +60,7 @@ int open(const char *name, int flags, ...);
 #endif
 #endif
 // void signal(int sig, VoidFunctionPtr func); -- this may work now!
-#if defined(HOST_i386) || defined(HOST_ALPHA)
+#if defined(HOST_i386) || defined(HOST_ALPHA) || defined(HOST_x86_64)
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
              struct timeval *timeout);
 #else
@@ -69,6 +69,9 @@ int select(int numBits, Thread *readFds, Thread *writeFds, Thread *exceptFds,
 #endif
 #endif
 
+#ifdef HOST_LINUX
+#include <unistd.h>		// glibc declares these, differently
+#else
 int unlink(char *name);
 int read(int filedes, char *buf, int numBytes);
 int write(int filedes, char *buf, int numBytes);
@@ -76,6 +79,7 @@ int lseek(int filedes, int offset, int whence);
 int tell(int filedes);
 int close(int filedes);
 int unlink(char *name);
+#endif
 
 // definition varies slightly from platform to platform, so don't 
 // define unless gcc complains
@@ -136,7 +140,7 @@ PollFile(int fd)
         pollTime.tv_usec = 0;                 	// no delay
 
 // poll file or socket
-#if defined(HOST_i386) || defined(HOST_ALPHA)
+#if defined(HOST_i386) || defined(HOST_ALPHA) || defined(HOST_x86_64)
     retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, &pollTime);
 #else
     retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
@@ -239,7 +243,7 @@ Lseek(int fd, int offset, int whence)
 int 
 Tell(int fd)
 {
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
     return lseek(fd,0,SEEK_CUR); // 386BSD doesn't have the tell() system call
 #else
     return tell(fd);
@@ -370,7 +374,7 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
 
     if (retVal != packetSize) {
         perror("in recvfrom");
-#ifdef HOST_ALPHA
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
         printf("called: %lx, got back %d, %d\n", (long) buffer, retVal, errno);
 #else
         printf("called: %x, got back %d, %d\n", (int) buffer, retVal, errno);
@@ -431,7 +435,7 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
 void 
 CallOnUserAbort(VoidNoArgFunctionPtr func)
 {
-#ifdef HOST_ALPHA
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
     (void)signal(SIGINT, (void (*)(int)) func);
 #else
     (void)signal(SIGINT, (VoidFunctionPtr) func);
@@ -477,12 +481,20 @@ Exit(int exitCode)
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
 //	now obsolete "srand" and "rand" because they are more portable!
+//
+//	The state of "rand" can't be saved, so for a checkpoint we keep
+//	the seed, and count the numbers drawn since.
 //----------------------------------------------------------------------
 
+static unsigned randomSeed = 1;		// as if srand(1), like "rand"
+static unsigned randomCalls = 0;	// # of calls to Random since then
+
 void 
 RandomInit(unsigned seed)
 {
     srand(seed);
+    randomSeed = seed;
+    randomCalls = 0;
 }
 
 //----------------------------------------------------------------------
@@ -493,9 +505,38 @@ RandomInit(unsigned seed)
 int 
 Random()
 {
+    randomCalls++;
     return rand();
 }
 
+//----------------------------------------------------------------------
+// RandomGetState
+// 	Return what RandomSetState needs to put the pseudo-random number
+//	generator back where it is now.
+//----------------------------------------------------------------------
+
+void
+RandomGetState(unsigned *seed, unsigned *calls)
+{
+    *seed = randomSeed;
+    *calls = randomCalls;
+}
+
+//----------------------------------------------------------------------
+// RandomSetState
+// 	Put the pseudo-random number generator in the state that
+//	RandomGetState returned, by seeding it again and drawing the
+//	same count of numbers.
+//----------------------------------------------------------------------
+
+void
+RandomSetState(unsigned seed, unsigned calls)
+{
+    RandomInit(seed);
+    while (randomCalls < calls)
+	(void) Random();
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before 
@@ -503,17 +544,38 @@ Random()
 //	the end of the array.  Particularly useful for catching overflow
 //	beyond fixed-size thread execution stacks.
 //
+//	Arrays given back with DeallocBoundedArray are kept, with their
+//	boundary pages still unmapped, and handed out again here; so once
+//	there are enough of them, a thread can be created and destroyed
+//	without any calls to UNIX.  The pooled arrays are all of one
+//	size (that of a thread stack), and are linked through their
+//	first word.
+//
 //	Note: Just return the useful part!
 //
 //	"size" -- amount of useful space needed (in bytes)
 //----------------------------------------------------------------------
 
+#define MaxPooledArrays	64	// keep no more than this many arrays
+
+static char *arrayPool = NULL;	// the arrays given back, if any
+static int numPooled = 0;	// # of arrays in the pool
+static int pooledSize = 0;	// the useful size of each of them
+
 char * 
 AllocBoundedArray(int size)
 {
-    int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
-
+    int pgSize;
+    char *ptr;
+
+    if ((numPooled > 0) && (size == pooledSize)) {
+	ptr = arrayPool;
+	arrayPool = *(char **) ptr;
+	numPooled--;
+	return ptr;
+    }
+    pgSize = getpagesize();
+    ptr = new char[pgSize * 2 + size];
     mprotect(ptr, pgSize, 0);
     mprotect(ptr + pgSize + size, pgSize, 0);
     return ptr + pgSize;
@@ -521,7 +583,8 @@ AllocBoundedArray(int size)
 
 //----------------------------------------------------------------------
 // DeallocBoundedArray
-// 	Deallocate an array of integers, unprotecting its two boundary pages.
+// 	Deallocate an array of integers, unprotecting its two boundary pages;
+//	or, if there is room, keep it in the pool for AllocBoundedArray.
 //
 //	"ptr" -- the array to be deallocated
 //	"size" -- amount of useful space in the array (in bytes)
@@ -530,8 +593,18 @@ AllocBoundedArray(int size)
 void 
 DeallocBoundedArray(char *ptr, int size)
 {
-    int pgSize = getpagesize();
-
+    int pgSize;
+
+    if (numPooled == 0)
+	pooledSize = size;
+    if ((size == pooledSize) && (numPooled < MaxPooledArrays)
+			&& (size >= (int) sizeof(char *))) {
+	*(char **) ptr = arrayPool;
+	arrayPool = ptr;
+	numPooled++;
+	return;
+    }
+    pgSize = getpagesize();
     mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
     mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
     delete [] (ptr - pgSize);
@@ -51,6 +51,8 @@ extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern int Random();
+extern void RandomGetState(unsigned *seed, unsigned *calls);
+extern void RandomSetState(unsigned seed, unsigned calls);
 
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
@@ -73,13 +73,30 @@ Timer::TimerExpired()
 // Timer::TimeOfNextInterrupt
 //      Return when the hardware timer device will next cause an interrupt.
 //	If randomize is turned on, make it a (pseudo-)random delay.
+//
+//	The random delays are kept in the event log (-record), and when
+//	it is replayed, the timer goes off at the logged times instead;
+//	the random number is still drawn, so that the rest of the random
+//	sequence is the same as when the log was made.
 //----------------------------------------------------------------------
 
 int 
 Timer::TimeOfNextInterrupt() 
 {
-    if (randomize)
-	return 1 + (Random() % (TimerTicks * 2));
-    else
+    int delay, when;
+
+    if (!randomize)
 	return TimerTicks; 
+    delay = 1 + (Random() % (TimerTicks * 2));
+    if (eventLog == NULL)
+	return delay;
+    if (eventLog->IsRecording())
+	eventLog->Record(TimerEvent, stats->totalTicks + delay, NULL, 0);
+    else if ((when = eventLog->NextEvent(TimerEvent)) >= 0) {
+	eventLog->Replay(TimerEvent, NULL, 0);
+	delay = when - stats->totalTicks;
+	if (delay < 1)			// running behind the log
+	    delay = 1;
+    }
+    return delay;
 }
@@ -70,6 +70,21 @@ WordToMachine(unsigned int word) { return WordToHost(word); }
 unsigned short
 ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 
+// Routines for reversing the bytes of Words and Short Words on any
+// host, for main memory when it is not kept in host order (see
+// Machine::hostOrder).
+
+unsigned int
+SwapWord(unsigned int word) {
+	 return ((word >> 24) & 0x000000ff) | ((word >> 8) & 0x0000ff00)
+	     | ((word << 8) & 0x00ff0000) | ((word << 24) & 0xff000000);
+}
+
+unsigned short
+SwapShort(unsigned short shortword) {
+	 return ((shortword << 8) & 0xff00) | ((shortword >> 8) & 0x00ff);
+}
+
 
 //----------------------------------------------------------------------
 // Machine::ReadMem
@@ -86,38 +101,53 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 
 bool
 Machine::ReadMem(int addr, int size, int *value)
+{
+    return ReadMemory<TRUE>(addr, size, value);
+}
+
+//----------------------------------------------------------------------
+// Machine::ReadMemory
+// 	Same as ReadMem; but if "Instrumented" is FALSE, the 'a' debug 
+//	messages are compiled out, for the uninstrumented run loop.
+//----------------------------------------------------------------------
+
+template <bool Instrumented> bool
+Machine::ReadMemory(int addr, int size, int *value)
 {
     int data;
     ExceptionType exception;
     int physicalAddress;
     
-    DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
+    if (Instrumented)
+	DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
+    exception = CachedTranslate(addr, &physicalAddress, size, FALSE);
     if (exception != NoException) {
 	machine->RaiseException(exception, addr);
 	return FALSE;
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = machine->mainMemory[physicalAddress ^ byteSwizzle];
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
-	*value = ShortToHost(data);
+	data = *(unsigned short *) 
+			&machine->mainMemory[physicalAddress ^ shortSwizzle];
+	*value = hostOrder ? data : SwapShort(data);
 	break;
 	
       case 4:
 	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
-	*value = WordToHost(data);
+	*value = hostOrder ? data : SwapWord(data);
 	break;
 
       default: ASSERT(FALSE);
     }
     
-    DEBUG('a', "\tvalue read = %8.8x\n", *value);
+    if (Instrumented)
+	DEBUG('a', "\tvalue read = %8.8x\n", *value);
     return (TRUE);
 }
 
@@ -136,30 +166,48 @@ Machine::ReadMem(int addr, int size, int *value)
 
 bool
 Machine::WriteMem(int addr, int size, int value)
+{
+    return WriteMemory<TRUE>(addr, size, value);
+}
+
+//----------------------------------------------------------------------
+// Machine::WriteMemory
+// 	Same as WriteMem; but if "Instrumented" is FALSE, the 'a' debug 
+//	messages are compiled out, for the uninstrumented run loop.
+//----------------------------------------------------------------------
+
+template <bool Instrumented> bool
+Machine::WriteMemory(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
      
-    DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
+    if (Instrumented)
+	DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
+    exception = CachedTranslate(addr, &physicalAddress, size, TRUE);
     if (exception != NoException) {
 	machine->RaiseException(exception, addr);
 	return FALSE;
     }
+    if (frameDecoded[physicalAddress / PageSize])	// might be overwriting
+	InvalidateDecodedFrame(physicalAddress / PageSize); // code
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	machine->mainMemory[physicalAddress ^ byteSwizzle]
+		= (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
-		= ShortToMachine((unsigned short) (value & 0xffff));
+	*(unsigned short *) &machine->mainMemory[physicalAddress ^ shortSwizzle]
+		= hostOrder ? (unsigned short) (value & 0xffff)
+			: SwapShort((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
 	*(unsigned int *) &machine->mainMemory[physicalAddress]
-		= WordToMachine((unsigned int) value);
+		= hostOrder ? (unsigned int) value
+			: SwapWord((unsigned int) value);
 	break;
 	
       default: ASSERT(FALSE);
@@ -168,6 +216,156 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+// Both versions are used by the simulator (mipssim.cc, mipsblock.cc).
+template bool Machine::ReadMemory<TRUE>(int addr, int size, int *value);
+template bool Machine::ReadMemory<FALSE>(int addr, int size, int *value);
+template bool Machine::WriteMemory<TRUE>(int addr, int size, int value);
+template bool Machine::WriteMemory<FALSE>(int addr, int size, int value);
+
+//----------------------------------------------------------------------
+// Machine::TranslateForCopy
+// 	Translate "virtAddr" for the kernel, to copy to or from user 
+//	memory.  A TLB miss is handed to the kernel's ExceptionHandler,
+//	just as for a user load or store, and the translation is retried
+//	once it returns.  Any other exception is returned to the caller,
+//	with the failing address in BadVAddrReg.
+//
+//	With a TLB, a miss on an address that is not in the page table
+//	the kernel refills the TLB from ("refillTable") is not handed on,
+//	since there is nothing to load: it is returned as an
+//	AddressErrorException (or a PageFaultException for an invalid
+//	entry), as Translate would without a TLB.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"physAddr" -- the place to store the physical address
+// 	"writing" -- if TRUE, the page is being written
+//----------------------------------------------------------------------
+
+ExceptionType
+Machine::TranslateForCopy(int virtAddr, int *physAddr, bool writing)
+{
+    ExceptionType exception;
+
+    for (;;) {
+	exception = Translate(virtAddr, physAddr, 1, writing);
+	if (exception == NoException)
+	    return NoException;
+	registers[BadVAddrReg] = virtAddr;
+	if (exception != PageFaultException || tlb == NULL)
+	    return exception;
+	if (refillTable != NULL) {
+	    unsigned int vpn = (unsigned) virtAddr / PageSize;
+
+	    if (vpn >= refillTableSize)
+		return AddressErrorException;
+	    if (!refillTable[vpn].valid)
+		return PageFaultException;
+	}
+	ExceptionHandler(PageFaultException);	// load the TLB
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyFromUser
+// 	Copy "size" bytes of user virtual memory at "virtAddr" into the
+//	kernel's "buffer".  Each page is translated once, and copied as
+//	a whole.
+//
+//   	Returns FALSE if some page could not be translated; the bytes
+//	before it have been copied.
+//----------------------------------------------------------------------
+
+bool
+Machine::CopyFromUser(int virtAddr, char *buffer, int size)
+{
+    int physAddr, n, i;
+
+    while (size > 0) {
+	if (TranslateForCopy(virtAddr, &physAddr, FALSE) != NoException)
+	    return FALSE;
+	n = PageSize - (unsigned) virtAddr % PageSize;	// rest of the page
+	if (n > size)
+	    n = size;
+	if (byteSwizzle == 0)
+	    bcopy(&mainMemory[physAddr], buffer, n);
+	else
+	    for (i = 0; i < n; i++)
+		buffer[i] = mainMemory[(physAddr + i) ^ byteSwizzle];
+	virtAddr += n;
+	buffer += n;
+	size -= n;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyToUser
+// 	Copy "size" bytes of the kernel's "buffer" into user virtual
+//	memory at "virtAddr", a page at a time.  Any predecoded 
+//	instructions in the pages written are thrown away.
+//
+//   	Returns FALSE if some page could not be translated, or is
+//	read-only; the bytes before it have been copied.
+//----------------------------------------------------------------------
+
+bool
+Machine::CopyToUser(int virtAddr, char *buffer, int size)
+{
+    int physAddr, n, i;
+
+    while (size > 0) {
+	if (TranslateForCopy(virtAddr, &physAddr, TRUE) != NoException)
+	    return FALSE;
+	n = PageSize - (unsigned) virtAddr % PageSize;
+	if (n > size)
+	    n = size;
+	if (frameDecoded[physAddr / PageSize])
+	    InvalidateDecodedFrame(physAddr / PageSize);
+	if (byteSwizzle == 0)
+	    bcopy(buffer, &mainMemory[physAddr], n);
+	else
+	    for (i = 0; i < n; i++)
+		mainMemory[(physAddr + i) ^ byteSwizzle] = buffer[i];
+	virtAddr += n;
+	buffer += n;
+	size -= n;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyStringFromUser
+// 	Copy a null-terminated string from user virtual memory at
+//	"virtAddr" into the kernel's "buffer", which holds "maxSize"
+//	bytes (including the null), a page at a time.
+//
+//   	Returns the length of the string, or -1 if some page could not 
+//	be translated, or the string does not fit.
+//----------------------------------------------------------------------
+
+int
+Machine::CopyStringFromUser(int virtAddr, char *buffer, int maxSize)
+{
+    int physAddr, n, i;
+    int length = 0;
+
+    while (length < maxSize) {
+	if (TranslateForCopy(virtAddr, &physAddr, FALSE) != NoException)
+	    return -1;
+	n = PageSize - (unsigned) virtAddr % PageSize;
+	if (n > maxSize - length)
+	    n = maxSize - length;
+	for (i = 0; i < n; i++)
+	    if ((buffer[length + i] = 
+			mainMemory[(physAddr + i) ^ byteSwizzle]) == '\0')
+		return length + i;
+	virtAddr += n;
+	length += n;
+    }
+    buffer[maxSize - 1] = '\0';		// too long
+    return -1;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -219,18 +417,23 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
+    } else {			// only look in the set for the page
+	int first = (vpn % tlbSets) * tlbWays;
+
+        for (entry = NULL, i = first; i < first + tlbWays; i++)
     	    if (tlb[i].valid && ((unsigned int)tlb[i].virtualPage == vpn)) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+	    stats->process->misses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	stats->process->hits++;
+	TLBTouch(i);
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -241,7 +444,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned int) NumPhysPages) { 
 	DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
 	return BusErrorException;
     }
@@ -253,3 +456,72 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::CachedTranslate
+// 	Translate a virtual address into a physical address, as Translate
+//	does, but look in the translation cache first.  On a hit, the
+//	page table (or TLB) is not touched at all.
+//
+//	This is safe because a page only gets into the cache after
+//	Translate has succeeded for it, and Translate has already set the
+//	use bit -- and, for "writeCache", the dirty bit -- in its entry.
+//	So the first write to each page still goes through Translate,
+//	and the bits are always what they would have been without the
+//	cache.  In return, the kernel must call FlushTranslationCache
+//	when it changes the translations (or clears a use or dirty bit).
+//
+//	The cache is not used when address debugging is on, so that
+//	every access is still traced by Translate.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"physAddr" -- the place to store the physical address
+//	"size" -- the amount of memory being read or written
+// 	"writing" -- if TRUE, use the cache of pages known to be writable
+//----------------------------------------------------------------------
+
+ExceptionType
+Machine::CachedTranslate(int virtAddr, int* physAddr, int size, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationCacheEntry *entry;
+    ExceptionType exception;
+
+    if (writing)
+	entry = &writeCache[vpn % TranslationCacheSize];
+    else
+	entry = &readCache[vpn % TranslationCacheSize];
+    if ((entry->virtualPage == vpn) && !(virtAddr & (size - 1))) {
+	*physAddr = entry->physicalPage * PageSize
+			+ (unsigned) virtAddr % PageSize;
+	return NoException;
+    }
+
+    exception = Translate(virtAddr, physAddr, size, writing);
+    if ((exception == NoException) && translationCacheOn) {
+	entry->virtualPage = vpn;
+	entry->physicalPage = *physAddr / PageSize;
+	if (writing)		// the page can be read, too
+	    readCache[vpn % TranslationCacheSize] = *entry;
+    }
+    return exception;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslationCache
+// 	Forget every translation in the translation cache, so that the
+//	next access to each page goes through Translate again.
+//
+//	Called by the kernel whenever a different page table is loaded
+//	(eg, AddrSpace::RestoreState), or a translation in use is
+//	changed.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTranslationCache()
+{
+    for (int i = 0; i < TranslationCacheSize; i++) {
+	readCache[i].virtualPage = NoCachedPage;
+	writeCache[i].virtualPage = NoCachedPage;
+    }
+}
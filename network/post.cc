@@ -18,6 +18,7 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // Mail::Mail
@@ -243,6 +244,10 @@ PostOffice::PostalDelivery()
 	ASSERT(0 <= mailHdr.to && mailHdr.to < numBoxes);
 	ASSERT(mailHdr.length <= MaxMailSize);
 
+	if (tracer != NULL)
+	    tracer->Instant(TraceNetwork, "network", "receive", "box",
+			    mailHdr.to);
+
 	// put into mailbox
         boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
     }
@@ -279,7 +284,7 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
     pktHdr.length = mailHdr.length + sizeof(MailHeader);
 
     // concatenate MailHeader and data
-#ifdef HOST_ALPHA
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
     bcopy((const char *)&mailHdr, buffer, sizeof(MailHeader));
 #else
     bcopy(&mailHdr, buffer, sizeof(MailHeader));
@@ -288,9 +293,13 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 
     sendLock->Acquire();   		// only one message can be sent
 					// to the network at any one time
+    if (tracer != NULL)
+	tracer->Begin(TraceNetwork, "network", "send");
     network->Send(pktHdr, buffer);
     messageSent->P();			// wait for interrupt to tell us
 					// ok to send the next message
+    if (tracer != NULL)
+	tracer->End(TraceNetwork, "network", "send");
     sendLock->Release();
 
     delete [] buffer;			// we've sent the message, so
@@ -0,0 +1,30 @@
+/* priority.c
+ *    Test program for SetPriority: an interactive process should not
+ *    queue behind a CPU-bound one.
+ *
+ *    Start matmult, then raise our own priority and do a short burst
+ *    of work, as a shell does for a command, before waiting for it.
+ *    Run it with time slicing, e.g. "nachos -rs 5 -x priority.noff",
+ *    with matmult.noff on the disk: the burst then takes the CPU from
+ *    matmult whenever it is ready.  Without the SetPriority call, the
+ *    two share the CPU, and "priority: done" comes about twice as late.
+ */
+
+#include "syscall.h"
+
+#define Burst	20000	/* iterations of the burst of work */
+
+int
+main()
+{
+    SpaceId hog;
+    int i;
+
+    hog = Exec("matmult.noff");
+    SetPriority(HighestPriority);
+    for (i = 0; i < Burst; i++)
+	;
+    Write("priority: done\n", 15, ConsoleOutput);
+    Join(hog);
+    Exit(0);
+}
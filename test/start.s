@@ -130,6 +130,22 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl SetPriority
+	.ent	SetPriority
+SetPriority:
+	addiu $2,$0,SC_SetPriority
+	syscall
+	j	$31
+	.end SetPriority
+
+	.globl ExecShare
+	.ent	ExecShare
+ExecShare:
+	addiu $2,$0,SC_ExecShare
+	syscall
+	j	$31
+	.end ExecShare
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -0,0 +1,185 @@
+// alarm.cc
+//	Routines to put threads to sleep until a given time, and to wake
+//	them up then.  See alarm.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+#define NeverDue	0x7fffffff	// "scheduledAt" when nothing is pending
+
+// dummy function because C++ does not allow pointers to member functions
+static void AlarmHandler(_int arg)
+{ Alarm *p = (Alarm *)arg; p->Expired(); }
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize an alarm clock with no thread sleeping in it.  No
+//	interrupt is scheduled until a thread goes to sleep.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    maxHeap = 16;
+    heap = new AlarmEntry[maxHeap];
+    numHeap = 0;
+    nextOrder = 0;
+    scheduledAt = NeverDue;
+    numScheduled = 0;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the heap.  The threads still sleeping are not ours.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until the time (stats->totalTicks)
+//	is "when"; return at once if that time has come already.  The
+//	thread is put on the heap, the heap grows if need be, and an
+//	interrupt is scheduled if it is to wake up first.
+//
+//	"when" is the time to wake up at.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    AlarmEntry entry;
+
+    if (when > stats->totalTicks) {
+	if (numHeap == maxHeap) {
+	    AlarmEntry *bigger = new AlarmEntry[maxHeap * 2];
+
+	    for (int i = 0; i < numHeap; i++)
+		bigger[i] = heap[i];
+	    delete [] heap;
+	    heap = bigger;
+	    maxHeap *= 2;
+	}
+	DEBUG('t', "Thread \"%s\" sleeping until time %d\n",
+	      currentThread->getName(), when);
+	entry.thread = currentThread;
+	entry.when = when;
+	entry.order = nextOrder++;
+	SiftUp(numHeap++, entry);
+	ScheduleFirst();
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Expired
+// 	Called, with interrupts disabled, by the interrupt scheduled for
+//	the first thread to wake up.  Wake up every thread whose time has
+//	come, and schedule an interrupt for the next one.
+//
+//	An interrupt scheduled for a thread that went to sleep later, but
+//	was to wake up earlier, does not take the place of the one already
+//	scheduled, so an interrupt can come when no thread is due; it
+//	just schedules the next one, if that is still needed.
+//----------------------------------------------------------------------
+
+void
+Alarm::Expired()
+{
+    Thread *thread;
+
+    numScheduled--;
+    if (scheduledAt <= stats->totalTicks)
+	scheduledAt = NeverDue;
+    while ((numHeap > 0) && (heap[0].when <= stats->totalTicks)) {
+	thread = heap[0].thread;
+	heap[0] = heap[--numHeap];
+	if (numHeap > 0)
+	    SiftDown(0);
+	DEBUG('t', "Waking up thread \"%s\" at time %d\n",
+	      thread->getName(), stats->totalTicks);
+	scheduler->ReadyToRun(thread);
+    }
+    ScheduleFirst();
+}
+
+//----------------------------------------------------------------------
+// Alarm::ScheduleFirst
+// 	Schedule an interrupt for when the thread at the top of the heap
+//	is to wake up, unless one is scheduled for that time or before.
+//----------------------------------------------------------------------
+
+void
+Alarm::ScheduleFirst()
+{
+    if ((numHeap == 0) || (heap[0].when >= scheduledAt))
+	return;
+    interrupt->Schedule(AlarmHandler, (_int) this,
+			heap[0].when - stats->totalTicks, AlarmInt);
+    scheduledAt = heap[0].when;
+    numScheduled++;
+}
+
+//----------------------------------------------------------------------
+// Before
+// 	Return TRUE if heap entry "a" is to wake up before "b": sooner, or
+//	at the same time, and it went to sleep first.
+//----------------------------------------------------------------------
+
+static bool
+Before(AlarmEntry *a, AlarmEntry *b)
+{
+    if (a->when != b->when)
+	return (a->when < b->when);
+    return (a->order < b->order);
+}
+
+//----------------------------------------------------------------------
+// Alarm::SiftUp
+// 	Put "entry" in the hole at heap[i], after moving down the entries
+//	above it that are to wake up after it.
+//----------------------------------------------------------------------
+
+void
+Alarm::SiftUp(int i, AlarmEntry entry)
+{
+    int parent;
+
+    for (; i > 0; i = parent) {
+	parent = (i - 1) / 2;
+	if (!Before(&entry, &heap[parent]))
+	    break;
+	heap[i] = heap[parent];
+    }
+    heap[i] = entry;
+}
+
+//----------------------------------------------------------------------
+// Alarm::SiftDown
+// 	Move heap[i] down the heap until it wakes up before its children.
+//----------------------------------------------------------------------
+
+void
+Alarm::SiftDown(int i)
+{
+    AlarmEntry entry = heap[i];
+    int child;
+
+    for (; (child = 2 * i + 1) < numHeap; i = child) {
+	if ((child + 1 < numHeap) && Before(&heap[child + 1], &heap[child]))
+	    child++;
+	if (!Before(&heap[child], &entry))
+	    break;
+	heap[i] = heap[child];
+    }
+    heap[i] = entry;
+}
@@ -0,0 +1,63 @@
+// alarm.h
+//	Data structures for an alarm clock, which kernel threads use to
+//	sleep until a given time (see Thread::SleepUntil).
+//
+//	The sleeping threads are kept in a binary heap on the time each
+//	is to wake up (threads waking at the same time in the order they
+//	went to sleep), and a single interrupt is scheduled, for the time
+//	the first of them is due.  So a waiting thread costs nothing until
+//	its time comes: it does not Yield in a loop to look at the clock,
+//	and no periodic timer interrupt is needed to wake it.  When no
+//	thread is ready, Interrupt::Idle moves the clock straight on to
+//	the time of that interrupt.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// An entry of the heap: a sleeping thread and when it is to wake up.
+
+struct AlarmEntry {
+    Thread *thread;
+    int when;				// stats->totalTicks to wake up at
+    unsigned int order;			// # of threads put to sleep before it
+};
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();				// initialize with no thread sleeping
+    ~Alarm();				// de-allocate the heap
+
+    void WaitUntil(int when);		// put the current thread to sleep
+					// until the time is "when"
+    void Expired();			// called by the interrupt: wake up
+					// the threads that are due
+    bool IsIdle() { return (numHeap == 0) && (numScheduled == 0); }
+					// no thread sleeping, and no
+					// interrupt pending?
+
+  private:
+    AlarmEntry *heap;			// the heap: heap[0] wakes up first
+    int numHeap;			// # of threads sleeping
+    int maxHeap;			// size of the "heap" array
+    unsigned int nextOrder;		// "order" for the next thread
+    int scheduledAt;			// time of the earliest interrupt
+					// scheduled, NeverDue if none
+    int numScheduled;			// # of interrupts not yet fired
+
+    void ScheduleFirst();		// Schedule an interrupt for heap[0],
+					// unless one will come by then
+    void SiftUp(int i, AlarmEntry entry);	// Put entry at heap[i], or
+					// above it, to restore the heap order
+    void SiftDown(int i);		// Restore the heap order below heap[i]
+};
+
+#endif // ALARM_H
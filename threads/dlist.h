@@ -0,0 +1,187 @@
+// dlist.h
+//	Data structures for intrusive doubly linked lists, for the kernel's
+//	queues of threads (ready lists, semaphore and condition queues).
+//
+//	Unlike List (list.h), which allocates a ListElement to hold each
+//	item, a DList links its items through a DLink kept in the item
+//	itself.  So putting an item on a list, or taking it off, never
+//	allocates or frees memory, and an item can be taken off from the
+//	middle of its list in constant time, without searching for it.
+//
+//	The price is that an item can be on only one list at a time for
+//	each DLink it has; the link remembers the list it is on, so this
+//	is checked.  The list is told which DLink of its items to use
+//	(a pointer to the member), so a list of threads holds only threads.
+//
+//	Everything is here, in the header, since these are templates.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DLIST_H
+#define DLIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+template <class T> class DList;
+
+// The following class defines the links embedded in an item that is
+// to be put on a DList.  Only DList uses them.
+
+template <class T>
+class DLink {
+  public:
+    DLink() { next = prev = NULL; list = NULL; }
+    bool IsLinked() { return (list != NULL); }	// is the item on a list?
+
+  private:
+    T *next;			// next item on the list, NULL if last
+    T *prev;			// previous item, NULL if first
+    DList<T> *list;		// the list the item is on, NULL if none
+    friend class DList<T>;
+};
+
+// The following class defines a doubly linked list of items of type T,
+// linked through the DLink member "link" of each.
+
+template <class T>
+class DList {
+  public:
+    DList(DLink<T> T::*member) { first = last = NULL; link = member; }
+				// initialize the list to be empty; "member"
+				// is the DLink in T to link the items with
+    ~DList() {}			// the items are not ours to free
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item);	// Put item at the end of the list
+    T *Remove();		// Take item off the front of the list,
+				// NULL if it is empty
+    bool Remove(T *item);	// Take item off the list, wherever it is;
+				// FALSE if it is not on this list
+    bool IsEmpty() { return (first == NULL); }
+    T *getFirst() { return first; }	// the items in order, for
+    T *getNext(T *item) { return (item->*link).next; }	// looking through
+    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every item
+
+  private:
+    T *first;			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+    DLink<T> T::*link;		// the links to use in each item
+};
+
+//----------------------------------------------------------------------
+// DList<T>::Prepend
+// 	Put an item at the front of the list.  It must not be on a list
+//	already (through the same links).
+//
+//	"item" is the thing to put on the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+DList<T>::Prepend(T *item)
+{
+    DLink<T> *l = &(item->*link);
+
+    ASSERT(l->list == NULL);
+    l->list = this;
+    l->prev = NULL;
+    l->next = first;
+    if (first == NULL)
+	last = item;
+    else
+	(first->*link).prev = item;
+    first = item;
+}
+
+//----------------------------------------------------------------------
+// DList<T>::Append
+// 	Put an item at the end of the list.  It must not be on a list
+//	already (through the same links).
+//
+//	"item" is the thing to put on the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+DList<T>::Append(T *item)
+{
+    DLink<T> *l = &(item->*link);
+
+    ASSERT(l->list == NULL);
+    l->list = this;
+    l->next = NULL;
+    l->prev = last;
+    if (last == NULL)
+	first = item;
+    else
+	(last->*link).next = item;
+    last = item;
+}
+
+//----------------------------------------------------------------------
+// DList<T>::Remove
+// 	Take the first item off the list, and return it; return NULL if
+//	the list is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+DList<T>::Remove()
+{
+    T *item = first;
+
+    if (item != NULL)
+	(void) Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// DList<T>::Remove
+// 	Take an item off the list, wherever it is on it, by relinking its
+//	neighbors.  Return FALSE (and do nothing) if it is not on this
+//	list.
+//
+//	"item" is the thing to take off.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+DList<T>::Remove(T *item)
+{
+    DLink<T> *l = &(item->*link);
+
+    if (l->list != this)
+	return FALSE;
+    if (l->prev == NULL)
+	first = l->next;
+    else
+	(l->prev->*link).next = l->next;
+    if (l->next == NULL)
+	last = l->prev;
+    else
+	(l->next->*link).prev = l->prev;
+    l->next = l->prev = NULL;
+    l->list = NULL;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// DList<T>::Mapcar
+//	Apply a function to each item on the list, in order, as
+//	List::Mapcar does.
+//
+//	"func" is the procedure to apply to each item.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+DList<T>::Mapcar(VoidFunctionPtr func)
+{
+    for (T *item = first; item != NULL; item = (item->*link).next)
+	(*func)((_int) item);
+}
+
+#endif // DLIST_H
@@ -9,7 +9,16 @@
 // 	Most of this file is not needed until later assignments.
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+//		-sched <priority|mlfq|stride> -schedstats [<unix file>]
+//		-trace <unix file> -sb <switches> [<nachos file>]
+//		-alarm <threads>
+//		-record <unix file> -replay <unix file>
+//		-s -tc -prof -hostorder -bigendian -cost [<costs>]
+//		-mem <pages>
+//		-tlb <entries> -tlbassoc <ways>
+//		-tlbpolicy <random|fifo|plru> -cpus <n>
+//		-checkpoint <unix file> <time> -restore <unix file>
+//		-x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -e <network orderability>
@@ -19,10 +28,62 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sched chooses how the next thread to run is picked: by fixed
+//	priorities (the default), or by a multilevel feedback queue, which
+//	moves threads down a level when they use up their time slice, and
+//	prints how long each thread ran, waited and took to first run;
+//	or by stride scheduling, which shares the CPU in proportion to
+//	each thread's tickets (see ExecShare), and also prints the share
+//	each asked for and got
+//    -record writes the events that come from outside Nachos (input,
+//	network packets and, with -rs, timer interrupts) to a UNIX file,
+//	with the time each happened
+//    -replay takes those events from a file made by -record instead,
+//	at the same times (the other flags should be the same)
+//    -schedstats prints, when Nachos halts, histograms for each thread
+//	of the time it waited on the ready list, ran each time it got the
+//	CPU and was blocked, with its context switches and the Yields that
+//	did nothing; they are also written to the UNIX file, if given, as
+//	JSON
+//    -trace records what the kernel does -- threads going to sleep,
+//	yielding and finishing, interrupt handlers, disk requests, system
+//	calls and network messages -- and writes it, when Nachos halts, to
+//	the UNIX file as Chrome trace events (for chrome://tracing or the
+//	Perfetto UI), with a tick shown as a microsecond
+//    -sb times this many context switches between two threads that
+//	only yield, and prints the switches per second; given a Nachos
+//	file, one of the threads takes on the address space of that user
+//	program, so that the saving of user registers is timed too
+//    -alarm forks this many threads that sleep in the alarm clock for
+//	different times, and print when they wake up
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -tc runs user programs with the threaded-code engine (mipsblock.cc)
+//    -prof prints the most executed user instructions when Nachos halts
+//    -hostorder keeps user memory in the host's byte order (this only
+//	makes a difference on a big-endian host)
+//    -bigendian keeps user memory big-endian, whatever the host, so 
+//	that the code -hostorder uses on a big-endian host can be tested
+//	on a little-endian one (see test/cmpHostOrder)
+//    -cost charges each user instruction by its kind, with pipeline
+//	stalls, instead of one tick each, and prints the instruction mix
+//	and CPI; the costs can be changed from the defaults in 
+//	machine/costmodel.cc with a list like "load=3,div=20,loaduse=2"
+//    -mem sets the number of pages of physical memory (default 64)
+//    -tlb uses a TLB with this many entries instead of a linear page
+//	table (the vm assignment always has a TLB, of 4 entries by default)
+//    -tlbassoc sets the number of entries in each TLB set (default: all)
+//    -tlbpolicy chooses the TLB entry to replace on a miss (default fifo)
+//    -cpus runs user programs on a multiprocessor with this many CPUs
+//	(lab7-8 only; default 1)
+//    -checkpoint saves the state of Nachos and its user program to a
+//	UNIX file, as the first system call to return at or after the
+//	given time while only the -x program is running returns (lab7-8
+//	only)
+//    -restore runs the user program saved by -checkpoint, from where it
+//	was saved, instead of -x (the other flags must be the same)
 //    -x runs a user program
 //    -c tests the console
 //
@@ -61,8 +122,10 @@
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
+extern void RestoreProcess(char *file);
 extern void MailTest(int networkID);
-extern void SynchTest(void);
+extern void SynchTest(void), SwitchBench(int switches, char *program);
+extern void AlarmTest(int threads);
 
 //----------------------------------------------------------------------
 // main
@@ -98,11 +161,32 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf ("\n\n%s\n\n",copyright);
+        if (!strcmp(*argv, "-sb")) {		// time context switches
+	    ASSERT(argc > 1);
+	    if ((argc > 2) && (**(argv + 2) != '-')) {
+		SwitchBench(atoi(*(argv + 1)), *(argv + 2));
+		argCount = 3;
+	    } else {
+		SwitchBench(atoi(*(argv + 1)), NULL);
+		argCount = 2;
+	    }
+	}
+        if (!strcmp(*argv, "-alarm")) {		// test the alarm clock
+	    ASSERT(argc > 1);
+	    AlarmTest(atoi(*(argv + 1)));
+	    argCount = 2;
+	}
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+#ifdef CHECKPOINT
+        } else if (!strcmp(*argv, "-restore")) {	// resume a user program
+	    ASSERT(argc > 1);
+            RestoreProcess(*(argv + 1));
+            argCount = 2;
+#endif
         } else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
@@ -0,0 +1,240 @@
+// readyqueue.cc
+//	Routines to manage the queue of threads that are ready to run,
+//	ordered by priority, or by pass.  See readyqueue.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "readyqueue.h"
+
+#include <strings.h>
+
+//----------------------------------------------------------------------
+// ReadyQueue::ReadyQueue
+// 	Initialize an empty list for each priority, or an empty heap.
+//
+//	"pass" is TRUE if the threads are to be ordered by pass, for
+//	stride scheduling.
+//----------------------------------------------------------------------
+
+ReadyQueue::ReadyQueue(bool pass)
+{
+    for (int i = 0; i < NumPriorities; i++)
+	lists[i] = new DList<Thread>(&Thread::queueLink);
+    ready = 0;
+    byPass = pass;
+    maxHeap = byPass ? 16 : 0;
+    heap = byPass ? new ReadyEntry[maxHeap] : NULL;
+    numHeap = 0;
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::~ReadyQueue
+// 	De-allocate the lists.
+//----------------------------------------------------------------------
+
+ReadyQueue::~ReadyQueue()
+{
+    for (int i = 0; i < NumPriorities; i++)
+	delete lists[i];
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Append
+// 	Put a thread at the end of the list for its priority, or on the
+//	heap, after the threads already there with the same pass; the
+//	heap grows if need be.
+//
+//	"thread" is the thread to be put on the queue.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::Append(Thread *thread)
+{
+    int priority = thread->getPriority();
+
+    if (byPass) {
+	ReadyEntry entry;
+
+	if (numHeap == maxHeap) {
+	    ReadyEntry *bigger = new ReadyEntry[maxHeap * 2];
+
+	    for (int i = 0; i < numHeap; i++)
+		bigger[i] = heap[i];
+	    delete [] heap;
+	    heap = bigger;
+	    maxHeap *= 2;
+	}
+	entry.thread = thread;
+	entry.pass = thread->getPass();
+	entry.order = nextOrder++;
+	SiftUp(numHeap++, entry);
+	return;
+    }
+    lists[priority]->Append(thread);
+    ready |= 1U << priority;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Remove
+// 	Take the thread at the front of the highest priority list that
+//	is not empty (or at the top of the heap) off the queue, and
+//	return it.  Return NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+ReadyQueue::Remove()
+{
+    int priority;
+    Thread *thread;
+
+    if (byPass) {
+	if (numHeap == 0)
+	    return NULL;
+	thread = heap[0].thread;
+	heap[0] = heap[--numHeap];
+	if (numHeap > 0)
+	    SiftDown(0);
+	return thread;
+    }
+    if (ready == 0)
+	return NULL;
+    priority = ffs((int) ready) - 1;
+    thread = lists[priority]->Remove();
+    if (lists[priority]->IsEmpty())
+	ready &= ~(1U << priority);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Remove
+// 	Take a particular thread off the queue, for instance because its
+//	priority is being changed.  Return FALSE if it was not on the queue.
+//	The thread's links say whether it is on the list for its priority,
+//	so it is taken off without looking for it.  On the heap, the
+//	thread has to be looked for; the last thread takes its place, and
+//	is moved up or down from there.
+//
+//	"thread" is the thread to be removed.
+//----------------------------------------------------------------------
+
+bool
+ReadyQueue::Remove(Thread *thread)
+{
+    int priority = thread->getPriority();
+
+    if (byPass) {
+	int i;
+
+	for (i = 0; i < numHeap; i++)
+	    if (heap[i].thread == thread)
+		break;
+	if (i == numHeap)
+	    return FALSE;
+	if (i < --numHeap) {
+	    SiftUp(i, heap[numHeap]);
+	    SiftDown(i);
+	}
+	return TRUE;
+    }
+    if (!lists[priority]->Remove(thread))
+	return FALSE;
+    if (lists[priority]->IsEmpty())
+	ready &= ~(1U << priority);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Top
+// 	Return the thread that Remove would return, without taking it off
+//	the queue, or NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+ReadyQueue::Top()
+{
+    if (byPass)
+	return (numHeap == 0) ? NULL : heap[0].thread;
+    if (ready == 0)
+	return NULL;
+    return lists[ffs((int) ready) - 1]->getFirst();
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Print
+// 	Print the threads on the queue, highest priority first (on the
+//	heap, in heap order, each with its pass).  For debugging.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::Print()
+{
+    for (int i = 0; i < numHeap; i++) {
+	printf("[%lld] ", heap[i].pass);
+	heap[i].thread->Print();
+    }
+    for (int i = 0; i < NumPriorities; i++)
+	if (ready & (1U << i)) {
+	    printf("[%d] ", i);
+	    lists[i]->Mapcar((VoidFunctionPtr) ThreadPrint);
+	}
+}
+
+//----------------------------------------------------------------------
+// Before
+// 	Return TRUE if the thread of heap entry "a" is to run before that
+//	of "b": it has a smaller pass, or the same pass and came first.
+//----------------------------------------------------------------------
+
+static bool
+Before(ReadyEntry *a, ReadyEntry *b)
+{
+    if (a->pass != b->pass)
+	return (a->pass < b->pass);
+    return (a->order < b->order);
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::SiftUp
+// 	Put "entry" in the hole at heap[i], after moving down the entries
+//	above it that are to run after it.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::SiftUp(int i, ReadyEntry entry)
+{
+    int parent;
+
+    for (; i > 0; i = parent) {
+	parent = (i - 1) / 2;
+	if (!Before(&entry, &heap[parent]))
+	    break;
+	heap[i] = heap[parent];
+    }
+    heap[i] = entry;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::SiftDown
+// 	Move heap[i] down the heap until it runs before its children.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::SiftDown(int i)
+{
+    ReadyEntry entry = heap[i];
+    int child;
+
+    for (; (child = 2 * i + 1) < numHeap; i = child) {
+	if ((child + 1 < numHeap) && Before(&heap[child + 1], &heap[child]))
+	    child++;
+	if (!Before(&heap[child], &entry))
+	    break;
+	heap[i] = heap[child];
+    }
+    heap[i] = entry;
+}
@@ -0,0 +1,75 @@
+// readyqueue.h
+//	Data structures for the queue of threads that are ready to run,
+//	ordered by priority, or, for stride scheduling, by pass.
+//
+//	There is a FIFO list for each priority, and a bitmap with a bit
+//	set for each list that is not empty; the next thread to run is
+//	at the front of the list whose bit is found first (find-first-set),
+//	so it takes the same time to find however many threads are ready.
+//	Priority 0 is the highest.
+//
+//	Under stride scheduling (see scheduler.h), the thread to run next
+//	is the one with the smallest pass instead, and the queue is a
+//	binary heap on pass (threads with the same pass in FIFO order), so
+//	that taking it off or putting a thread on takes O(log n) time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef READYQUEUE_H
+#define READYQUEUE_H
+
+#include "copyright.h"
+#include "dlist.h"
+#include "thread.h"
+
+// An entry of the heap: the pass of the thread is kept as it was when
+// the thread was put on the queue (it does not run while it is there).
+
+struct ReadyEntry {
+    Thread *thread;
+    long long pass;
+    unsigned int order;			// # of threads put on before it
+};
+
+// The following class defines a queue of ready threads, one FIFO
+// list for each priority (see NumPriorities in thread.h), or a heap.
+
+class ReadyQueue {
+  public:
+    ReadyQueue(bool byPass = FALSE);	// initialize the queue to be empty;
+					// "byPass" for stride scheduling
+    ~ReadyQueue();			// de-allocate the queue
+
+    void Append(Thread *thread);	// put thread at the end of the list
+					// for its priority (or on the heap)
+    Thread *Remove();			// take the first thread of the
+					// highest priority (or the smallest
+					// pass) off the queue, NULL if the
+					// queue is empty
+    bool Remove(Thread *thread);	// take thread off the queue, if it
+					// is there
+    Thread *Top();			// the thread Remove() would return,
+					// left on the queue
+    bool IsEmpty() { return byPass ? (numHeap == 0) : (ready == 0); }
+    void Print();			// print the threads, highest
+					// priority first
+
+  private:
+    DList<Thread> *lists[NumPriorities];	// the ready threads of each
+					// priority, linked by queueLink
+    unsigned int ready;			// bit i is set if lists[i] is not empty
+
+    bool byPass;			// a heap on pass, instead?
+    ReadyEntry *heap;			// the heap: heap[0] runs next
+    int numHeap;			// # of threads on the heap
+    int maxHeap;			// size of the "heap" array
+    unsigned int nextOrder;		// "order" for the next thread
+
+    void SiftUp(int i, ReadyEntry entry);	// Put entry at heap[i], or
+					// above it, to restore the heap order
+    void SiftDown(int i);		// Restore the heap order below heap[i]
+};
+
+#endif // READYQUEUE_H
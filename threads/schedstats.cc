@@ -0,0 +1,300 @@
+// schedstats.cc
+//	Routines to keep and report the scheduler statistics of each
+//	thread.  See schedstats.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "schedstats.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize a histogram with no times counted.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    samples = 0;
+    total = 0;
+    max = 0;
+    for (int i = 0; i < HistBuckets; i++)
+	count[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Add
+// 	Count a time in its bucket: 0 in bucket 0, and a time of 2^(i-1)
+//	to 2^i - 1 ticks in bucket i.
+//
+//	"ticks" is the time to count.
+//----------------------------------------------------------------------
+
+void
+Histogram::Add(int ticks)
+{
+    int bucket = 0;
+
+    if (ticks < 0)
+	ticks = 0;
+    while ((ticks >> bucket) != 0 && bucket < HistBuckets - 1)
+	bucket++;
+    count[bucket]++;
+    samples++;
+    total += ticks;
+    if (ticks > max)
+	max = ticks;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print the number of times, their mean and the longest, then the
+//	range of times and the count of each bucket that is not empty.
+//
+//	"title" says what the times are.
+//----------------------------------------------------------------------
+
+void
+Histogram::Print(const char *title)
+{
+    printf("    %s: %d, mean %d, max %d\n", title, samples,
+	(samples > 0) ? (int) (total / samples) : 0, max);
+    for (int i = 0; i < HistBuckets; i++) {
+	if (count[i] == 0)
+	    continue;
+	if (i == 0)
+	    printf("%20d: %d\n", 0, count[i]);
+	else if (i == HistBuckets - 1)
+	    printf("%13d and up: %d\n", 1 << (i - 1), count[i]);
+	else
+	    printf("%10d - %-7d: %d\n", 1 << (i - 1), (1 << i) - 1, count[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// Histogram::Write
+// 	Write the histogram as a JSON object: the counts of all the
+//	buckets are written, so that bucket i is element i.
+//
+//	"file" is the open UNIX file to write to.
+//----------------------------------------------------------------------
+
+void
+Histogram::Write(FILE *file)
+{
+    fprintf(file, "{\"samples\": %d, \"total\": %lld, \"max\": %d, \"buckets\": [",
+	samples, total, max);
+    for (int i = 0; i < HistBuckets; i++)
+	fprintf(file, (i == 0) ? "%d" : ", %d", count[i]);
+    fprintf(file, "]}");
+}
+
+//----------------------------------------------------------------------
+// SchedStats::SchedStats
+// 	Start keeping scheduler statistics, for no thread yet.
+//
+//	"name" is the UNIX file to write them to when Nachos halts, or
+//	NULL to only print them.
+//----------------------------------------------------------------------
+
+SchedStats::SchedStats(char *name)
+{
+    maxThreads = 16;
+    threads = new ThreadSchedStats[maxThreads];
+    numThreads = 0;
+    switches = 0;
+    fileName = name;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::~SchedStats
+// 	De-allocate the statistics.
+//----------------------------------------------------------------------
+
+SchedStats::~SchedStats()
+{
+    delete [] threads;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Find
+// 	Return the statistics of a thread; the first time, give it a
+//	number (Thread::schedId) and start them, the array growing if need
+//	be.  The statistics outlive the thread, to be reported at the end.
+//
+//	"thread" is the thread to look up.
+//----------------------------------------------------------------------
+
+ThreadSchedStats *
+SchedStats::Find(Thread *thread)
+{
+    ThreadSchedStats *s;
+
+    if (thread->schedId >= 0)
+	return &threads[thread->schedId];
+    if (numThreads == maxThreads) {
+	ThreadSchedStats *bigger = new ThreadSchedStats[maxThreads * 2];
+
+	for (int i = 0; i < numThreads; i++)
+	    bigger[i] = threads[i];
+	delete [] threads;
+	threads = bigger;
+	maxThreads *= 2;
+    }
+    thread->schedId = numThreads;
+    s = &threads[numThreads++];
+    strncpy(s->name, thread->getName(), sizeof(s->name) - 1);
+    s->name[sizeof(s->name) - 1] = '\0';
+    s->voluntary = s->involuntary = 0;
+    s->yields = s->idleYields = 0;
+    s->sliceStart = (thread == currentThread) ? stats->totalTicks : -1;
+    s->blockedSince = -1;
+    return s;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Ready
+// 	Called when a thread is put on the ready list: if it was asleep,
+//	count how long.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Ready(Thread *thread)
+{
+    ThreadSchedStats *s = Find(thread);
+
+    if (s->blockedSince >= 0) {
+	s->blocked.Add(stats->totalTicks - s->blockedSince);
+	s->blockedSince = -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Dispatched
+// 	Called when a thread is about to get the CPU: count how long it
+//	waited on the ready list, and the context switch, if it is not
+//	the thread that had the CPU.  Its time slice starts then.
+//
+//	"when" is the time it gets the CPU.
+//	"waited" is the time it was ready.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Dispatched(Thread *thread, int when, int waited)
+{
+    ThreadSchedStats *s = Find(thread);
+
+    s->latency.Add(waited);
+    s->sliceStart = when;
+    if (thread != currentThread)
+	switches++;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Stopped
+// 	Called when a thread gives up the CPU: count how long it ran, and
+//	why it stopped, from its status -- it went to sleep (BLOCKED),
+//	gave the CPU to another thread (READY), or finished.  Nothing
+//	happens if the thread was stopped already, as when Run switches
+//	away from a thread that went to sleep.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Stopped(Thread *thread)
+{
+    ThreadSchedStats *s = Find(thread);
+
+    if (s->sliceStart < 0)
+	return;
+    s->slice.Add(stats->totalTicks - s->sliceStart);
+    s->sliceStart = -1;
+    if (thread == threadToBeDestroyed || thread->getStatus() == TERMINATED)
+	return;
+    if (thread->getStatus() == BLOCKED) {
+	s->voluntary++;
+	s->blockedSince = stats->totalTicks;
+    } else
+	s->involuntary++;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Yielded
+// 	Count a call of Thread::Yield, and whether it did anything.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Yielded(Thread *thread, bool switched)
+{
+    ThreadSchedStats *s = Find(thread);
+
+    s->yields++;
+    if (!switched)
+	s->idleYields++;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Print
+// 	Print the number of context switches, and the statistics of each
+//	thread, in the order they were first seen.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Print()
+{
+    ThreadSchedStats *s;
+
+    printf("Scheduler: %d context switches, %d threads\n", switches,
+	numThreads);
+    for (int i = 0; i < numThreads; i++) {
+	s = &threads[i];
+	printf("  %s: %d voluntary, %d involuntary switches, "
+	    "%d yields (%d did nothing)\n", s->name, s->voluntary,
+	    s->involuntary, s->yields, s->idleYields);
+	s->latency.Print("run-queue latency");
+	s->slice.Print("time slice");
+	s->blocked.Print("blocked");
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Write
+// 	Write the statistics to the UNIX file given to the constructor,
+//	if any, as a JSON object, with a list of the threads.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Write()
+{
+    FILE *file;
+    ThreadSchedStats *s;
+
+    if (fileName == NULL)
+	return;
+    file = fopen(fileName, "w");
+    if (file == NULL) {
+	perror(fileName);
+	return;
+    }
+    fprintf(file, "{\"ticks\": %d, \"switches\": %d, \"threads\": [\n",
+	stats->totalTicks, switches);
+    for (int i = 0; i < numThreads; i++) {
+	s = &threads[i];
+	fprintf(file, "  {\"name\": \"");
+	for (char *c = s->name; *c != '\0'; c++)
+	    fprintf(file, (*c == '"' || *c == '\\') ? "\\%c" : "%c", *c);
+	fprintf(file, "\", \"voluntary\": %d, \"involuntary\": %d, "
+	    "\"yields\": %d, \"idleYields\": %d,\n", s->voluntary,
+	    s->involuntary, s->yields, s->idleYields);
+	fprintf(file, "   \"latency\": ");
+	s->latency.Write(file);
+	fprintf(file, ",\n   \"slice\": ");
+	s->slice.Write(file);
+	fprintf(file, ",\n   \"blocked\": ");
+	s->blocked.Write(file);
+	fprintf(file, "}%s\n", (i < numThreads - 1) ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+}
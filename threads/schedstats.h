@@ -0,0 +1,97 @@
+// schedstats.h
+//	Data structures for scheduler statistics (-schedstats): for each
+//	thread, histograms of how long it waited on the ready list before
+//	it ran (run-queue latency), how long it ran each time it got the
+//	CPU (time slice), and how long it was blocked each time it went to
+//	sleep, with the number of times it gave up the CPU and of the
+//	Yields that did nothing.
+//
+//	Times are in simulated ticks, taken by the scheduler when the
+//	events happen (see the calls in scheduler.cc).  The statistics are
+//	printed when Nachos halts, and can also be written to a file as
+//	JSON, for other programs to read.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDSTATS_H
+#define SCHEDSTATS_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define HistBuckets	24	// bucket 0 counts times of 0 ticks, bucket
+				// i times of 2^(i-1) to 2^i - 1 ticks, and
+				// the last one every longer time as well
+
+// The following class defines a histogram of times, in buckets that
+// double in size.
+
+class Histogram {
+  public:
+    Histogram();			// initialize to no samples
+
+    void Add(int ticks);		// count a time
+    void Print(const char *title);	// print the buckets with samples
+    void Write(FILE *file);		// write them as a JSON object
+
+    int samples;			// # of times counted
+    long long total;			// their sum
+    int max;				// the longest
+    int count[HistBuckets];		// # of times in each bucket
+};
+
+// The following class defines the statistics kept for each thread.
+
+class ThreadSchedStats {
+  public:
+    char name[32];			// the thread's name, maybe cut short
+    Histogram latency;			// time from ready to running
+    Histogram slice;			// time from running to giving up the CPU
+    Histogram blocked;			// time from going to sleep to ready
+    int voluntary;			// # of times it went to sleep
+    int involuntary;			// # of times it gave the CPU to another
+					// thread while still ready
+    int yields;				// # of times it called Yield
+    int idleYields;			// # of those that did not switch
+    int sliceStart;			// when it last got the CPU, -1 if it
+					// is not running
+    int blockedSince;			// when it last went to sleep, -1 if
+					// it is not asleep
+};
+
+// The following class defines the statistics for every thread.
+
+class SchedStats {
+  public:
+    SchedStats(char *fileName);		// start keeping statistics; write
+					// them to this UNIX file at the end,
+					// if it is not NULL
+    ~SchedStats();
+
+    void Ready(Thread *thread);		// thread is put on the ready list
+    void Dispatched(Thread *thread, int when, int waited);
+					// thread gets the CPU at "when",
+					// after waiting
+    void Stopped(Thread *thread);	// thread gives up the CPU (its
+					// status says why)
+    void Yielded(Thread *thread, bool switched);
+					// thread called Yield
+
+    void Print();			// print the statistics
+    void Write();			// and write them to the file, if any
+
+  private:
+    ThreadSchedStats *threads;		// the statistics of each thread,
+					// numbered by Thread::schedId
+    int numThreads;			// # of threads seen
+    int maxThreads;			// size of the "threads" array
+    int switches;			// # of context switches
+    char *fileName;			// where to write them, or NULL
+
+    ThreadSchedStats *Find(Thread *thread);	// the statistics of thread,
+					// which are started if it has none
+};
+
+#endif // SCHEDSTATS_H
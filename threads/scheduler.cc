@@ -11,8 +11,18 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The thread of the highest priority runs first; threads of the
+//	same priority run in FIFO order.  A thread woken by an interrupt
+//	handler preempts the interrupted thread if it is more important.
+//
+//	Under the multilevel feedback queue (-sched mlfq), the scheduler
+//	sets the priorities itself: threads that use up their quantum
+//	sink, and threads that give up the CPU early (waiting for I/O)
+//	stay near the top.  Under stride scheduling (-sched stride),
+//	threads share the CPU in proportion to their tickets instead,
+//	and the share each was entitled to is reported with the share it
+//	got.  The time each thread runs and waits is kept under every
+//	policy.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -25,11 +35,20 @@
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//
+//	"how" is the scheduling policy.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicy how)
 { 
-    readyList = new List("Ready"); 
+    readyList = new ReadyQueue(how == StrideSched); 
+    policy = how;
+    chargeStart = chargeIdle = 0;
+    boosts = 0;
+    nextBoost = MLFQBoostTicks;
+    globalPass = 0;
+    virtualTime = 0;
+    competingTickets = 0;
 #ifdef USER_PROGRAM
     terminatedList = new List("Terminated");
     waitingList = new List("Waiting");
@@ -71,9 +90,25 @@ void
 Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
+    if (schedStats != NULL)
+	schedStats->Ready(thread);
 
+    if (thread == currentThread)	// yielding: it may have used up
+	(void) Charge();		// its quantum
+    else if (policy == MLFQSched)
+	Refresh(thread);
+    else if (policy == StrideSched) {
+	if (thread->pass < globalPass)	// no credit for time away
+	    thread->pass = globalPass;
+	StartShare(thread);
+    }
+    thread->readySince = stats->totalTicks;
+    if (thread->firstReady < 0)
+	thread->firstReady = stats->totalTicks;
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    readyList->Append(thread);
+    if (interrupt->InHandler() && Before(thread, currentThread))
+	interrupt->YieldOnReturn();	// preempt the interrupted thread
 }
 
 //----------------------------------------------------------------------
@@ -87,7 +122,38 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+    return readyList->Remove();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldYield
+// 	Return TRUE if the thread FindNextToRun would return is not to run
+//	after the running thread: it has the same or a higher priority
+//	(under stride scheduling, the same or a smaller pass).  Used by
+//	Thread::Yield to keep the CPU when only less important threads
+//	are ready, and by TimerTick.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldYield ()
+{
+    Thread *next = readyList->Top();
+
+    return (next != NULL) && !Before(currentThread, next);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveReady
+// 	Take a thread off the ready list (its priority is being changed).
+//	Return FALSE if it was not there.
+//
+//	"thread" is the thread to be taken off the ready list.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::RemoveReady (Thread *thread)
+{
+    return readyList->Remove(thread);
 }
 
 //----------------------------------------------------------------------
@@ -119,6 +185,10 @@ Scheduler::Run (Thread *nextThread)
     }
 #endif
     
+    (void) Charge();			    // the time is now the new thread's
+    if (schedStats != NULL)
+	schedStats->Stopped(oldThread);
+    Dispatch(nextThread, stats->totalTicks);
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
@@ -166,6 +236,280 @@ Scheduler::Run (Thread *nextThread)
 #endif
 }
 
+//----------------------------------------------------------------------
+// Scheduler::TimerTick
+// 	Called by the timer interrupt handler.  Under fixed priorities,
+//	every timer interrupt is a time slice (-rs); under the multilevel
+//	feedback queue, the running thread is charged for its time, and
+//	is told to give up the CPU only if its quantum is up.  This is
+//	also where every thread is moved back up, when it is time.  Under
+//	stride scheduling, the running thread is charged, and gives up the
+//	CPU if its pass is no longer the smallest.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::TimerTick()
+{
+    if (policy == PrioritySched)
+	return TRUE;
+    if (policy == StrideSched) {
+	(void) Charge();
+	return ShouldYield();
+    }
+    if (stats->totalTicks >= nextBoost)
+	Boost();
+    return Charge();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Charge the running thread for the time since it was last charged,
+//	not counting the time the CPU was idle (the thread was asleep).
+//	Under the multilevel feedback queue, the time also counts toward
+//	the quantum of its level; once that is used up, the thread moves
+//	down a level, with a new quantum.  Under stride scheduling, it
+//	moves the thread's pass on, and the virtual time (the ticks run
+//	for each ticket competing) that the shares are worked out from.
+//
+//	Returns TRUE if the thread has used up its quantum.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Charge()
+{
+    Thread *thread = currentThread;
+    int ticks = (stats->totalTicks - chargeStart) 
+				- (stats->idleTicks - chargeIdle);
+    int level;
+
+    chargeStart = stats->totalTicks;
+    chargeIdle = stats->idleTicks;
+    if (ticks < 0)
+	ticks = 0;
+    thread->ticksUsed += ticks;
+    if (policy == StrideSched) {
+	if (thread->status == RUNNING)	// the first thread never became
+	    StartShare(thread);		// ready
+	thread->pass += (long long) ticks * (StrideLarge / thread->tickets);
+	if (thread->shareStart >= 0)
+	    virtualTime += (double) ticks / competingTickets;
+    }
+    if (policy != MLFQSched)
+	return FALSE;
+    Refresh(thread);
+    thread->quantumUsed += ticks;
+    level = thread->priority;
+    if (level >= MLFQLevels)		// put below the queue by setPriority
+	level = MLFQLevels - 1;
+    if (thread->quantumUsed < MLFQQuantum(level))
+	return FALSE;
+    DEBUG('t', "Thread \"%s\" used up its quantum at level %d\n",
+	thread->getName(), thread->priority);
+    if (thread->priority < MLFQLevels - 1)
+	thread->priority++;
+    thread->quantumUsed = 0;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Refresh
+// 	Under the multilevel feedback queue, put a thread that has not
+//	been placed since the last boost (or ever) at the top level, with
+//	a new quantum.  Threads that are not on the ready list when the
+//	boost happens are moved up this way when they next run or become
+//	ready.
+//
+//	"thread" is the thread to check.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Refresh(Thread *thread)
+{
+    if (thread->boostEpoch == boosts)
+	return;
+    thread->priority = 0;
+    thread->quantumUsed = 0;
+    thread->boostEpoch = boosts;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost
+// 	Under the multilevel feedback queue, move every thread back up to
+//	the top level, so that threads that have sunk get to run, and
+//	threads whose behavior has changed are placed afresh.  Threads on
+//	the ready list move now, in the order they would have run; the
+//	others when they next run or become ready (see Refresh).
+//----------------------------------------------------------------------
+
+void
+Scheduler::Boost()
+{
+    List moved;
+    Thread *thread;
+
+    boosts++;
+    nextBoost = stats->totalTicks + MLFQBoostTicks;
+    DEBUG('t', "Moving every thread up to the top level\n");
+    while ((thread = readyList->Remove()) != NULL)
+	moved.Append((void *) thread);
+    while ((thread = (Thread *) moved.Remove()) != NULL) {
+	Refresh(thread);
+	readyList->Append(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	Count the time a thread waited on the ready list, as it is about
+//	to run; the first time, this is also its response time.  Under
+//	stride scheduling, its pass is where threads coming back start.
+//
+//	"thread" is the thread about to run.
+//	"when" is the time it starts running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch(Thread *thread, int when)
+{
+    if (when > thread->readySince)
+	thread->waitTicks += when - thread->readySince;
+    if (thread->responseTicks < 0 && thread->firstReady >= 0)
+	thread->responseTicks = (when > thread->firstReady) ? 
+					when - thread->firstReady : 0;
+    thread->dispatches++;
+    if (schedStats != NULL)
+	schedStats->Dispatched(thread, when,
+	    (when > thread->readySince) ? when - thread->readySince : 0);
+    if (thread->pass > globalPass)
+	globalPass = thread->pass;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Finished
+// 	Charge a thread that is finishing for the last of its time, and,
+//	under the multilevel feedback queue or stride scheduling, keep its
+//	times (and share) to be printed with the other statistics.
+//
+//	"thread" is the thread that is finishing; it must be running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Finished(Thread *thread)
+{
+    ASSERT(thread == currentThread);
+    (void) Charge();
+    EndShare(thread);
+    if (policy != PrioritySched)
+	stats->CountThread(thread->getName(), thread->ticksUsed, 
+	    thread->waitTicks, 
+	    (thread->responseTicks < 0) ? 0 : thread->responseTicks,
+	    thread->dispatches, 
+	    (policy == StrideSched) ? thread->tickets : 0,
+	    (int) thread->entitledTicks);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Blocked
+// 	Charge a thread that is going to sleep for the last of its time,
+//	before the CPU goes idle or to another thread; under stride
+//	scheduling, it stops competing for the CPU until it is ready
+//	again.  Its time slice ends here (for -schedstats), not in Run.
+//	Called by Thread::Sleep.
+//
+//	"thread" is the thread going to sleep; it must be running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Blocked(Thread *thread)
+{
+    ASSERT(thread == currentThread);
+    if (schedStats != NULL)
+	schedStats->Stopped(thread);
+    if (policy != StrideSched)
+	return;				// Run will charge it
+    (void) Charge();
+    EndShare(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetTickets
+// 	Give a thread a new number of tickets, for stride scheduling.  If
+//	it is competing for the CPU, its share so far is worked out with
+//	the old number.  Its pass stays where it is, so a thread that is
+//	ready keeps its place on the ready list.
+//
+//	"thread" is the thread to change.
+//	"tickets" is its new number of tickets, 1 to MaxTickets.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetTickets(Thread *thread, int tickets)
+{
+    bool competing = (thread->shareStart >= 0);
+
+    ASSERT(tickets > 0 && tickets <= MaxTickets);
+    if (competing) {
+	if (thread == currentThread)
+	    (void) Charge();		// at the old rate
+	EndShare(thread);
+    }
+    thread->tickets = tickets;
+    if (competing)
+	StartShare(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Before
+// 	Return TRUE if thread "a" is to run before thread "b": it has a
+//	higher priority, or, under stride scheduling, a smaller pass.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Before(Thread *a, Thread *b)
+{
+    if (policy == StrideSched)
+	return (a->pass < b->pass);
+    return (a->priority < b->priority);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StartShare
+// 	Under stride scheduling, count a thread among those competing for
+//	the CPU, from now on: as the virtual time goes on, it is entitled
+//	to its tickets' worth of the time run.  Nothing is done if it
+//	already is.
+//
+//	"thread" is the thread that is ready, or running.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartShare(Thread *thread)
+{
+    if (policy != StrideSched || thread->shareStart >= 0)
+	return;
+    thread->shareStart = virtualTime;
+    competingTickets += thread->tickets;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndShare
+// 	Stop counting a thread among those competing for the CPU, adding
+//	what it was entitled to while it was to its total.
+//
+//	"thread" is the thread that is blocking or finishing.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndShare(Thread *thread)
+{
+    if (policy != StrideSched || thread->shareStart < 0)
+	return;
+    thread->entitledTicks += thread->tickets 
+				* (virtualTime - thread->shareStart);
+    thread->shareStart = -1;
+    competingTickets -= thread->tickets;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -176,7 +520,7 @@ Scheduler::Print()
 {
     printf("=======================Scheduler Queue=========================\n");
     printf("Ready list contents: ");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    readyList->Print();
     printf("\nWaiting list contents: ");
     waitingList->Mapcar((VoidFunctionPtr) ThreadPrint);
     printf("\nTerminated list contents: ");
@@ -1,6 +1,7 @@
 // scheduler.h 
 //	Data structures for the thread dispatcher and scheduler.
-//	Primarily, the list of threads that are ready to run.
+//	Primarily, the list of threads that are ready to run, kept
+//	by priority, or by pass (see readyqueue.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -12,6 +13,30 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "readyqueue.h"
+#include "stats.h"
+
+// The scheduling policies, chosen with -sched
+enum SchedPolicy { PrioritySched,	// fixed priorities (the default)
+		   MLFQSched,		// multilevel feedback queue
+		   StrideSched };	// stride scheduling
+
+// Under the multilevel feedback queue, priorities 0 (where threads
+// start) to MLFQLevels - 1 are the levels of the queue.  A thread that
+// has run for the quantum of its level, whether in one go or a bit at a
+// time, moves down a level; every MLFQBoostTicks, every thread moves
+// back up to the top.  The timer is checked every TimerTicks.
+#define MLFQLevels		4
+#define MLFQQuantum(level)	((2 * TimerTicks) << (level))
+#define MLFQBoostTicks		50000
+
+// Under stride scheduling, each thread gets a share of the CPU in
+// proportion to its tickets (see DefaultTickets in thread.h).  Running
+// for a tick adds StrideLarge / tickets to its pass, and the ready
+// thread with the smallest pass runs next; a thread that has been
+// away starts again at the pass of the last thread to run, so that
+// it cannot save up time.  Priorities are ignored.
+#define StrideLarge		(1 << 20)
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -19,18 +44,53 @@
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedPolicy how = PrioritySched);
+					// Initialize list of ready threads 
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
-    Thread* FindNextToRun();		// Dequeue first thread on the ready 
-					// list, if any, and return thread.
+    Thread* FindNextToRun();		// Dequeue first thread of the highest
+					// priority on the ready list, if any,
+					// and return thread.
+    bool ShouldYield();			// Is a thread as important as the
+					// running one ready?
+    bool RemoveReady(Thread* thread);	// Take thread off the ready list
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+
+    SchedPolicy getPolicy() { return policy; }
+    bool TimerTick();			// Charge the running thread at a
+					// timer interrupt; TRUE if it should
+					// give up the CPU
+    void Finished(Thread* thread);	// Count the times of a thread that
+					// is finishing
+    void Blocked(Thread* thread);	// Charge a thread that is going
+					// to sleep
+    void SetTickets(Thread* thread, int tickets);
+					// Change the tickets of a thread
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
+    ReadyQueue *readyList;	// queue of threads that are ready to run,
 				// but not running
+    SchedPolicy policy;		// how to choose the next thread
+    int chargeStart;		// when the running thread was last charged
+    int chargeIdle;		// the idle time then
+    int boosts;			// # of times every thread has moved up
+    int nextBoost;		// when they will next move up
+    long long globalPass;	// the pass of the last thread to run
+    double virtualTime;		// ticks run per ticket competing
+    int competingTickets;	// tickets of the threads ready or running
+
+    bool Charge();		// Charge the running thread for its time;
+				// TRUE if its quantum is up
+    void Refresh(Thread* thread);	// Put thread back at the top, if
+				// there was a boost since it was placed
+    void Boost();		// Move every thread back up to the top
+    bool Before(Thread* a, Thread* b);	// Should a run before b?
+    void StartShare(Thread* thread);	// Thread starts/stops competing
+    void EndShare(Thread* thread);	// for the CPU
+    void Dispatch(Thread* thread, int when);
+				// Count the wait of a thread about to run
 #ifdef USER_PROGRAM
     List *waitingList;    // Join产生的陷入阻塞的线程队列
     List *terminatedList; // Join等操作产生的执行结束的线程队列
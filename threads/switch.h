@@ -6,7 +6,7 @@
  *	call frame, etc, are all specific to a processor architecture.
  *
  * 	This file currently supports the DEC MIPS, SUN SPARC, HP PA-RISC,
- *  Intel 386 and DEC ALPHA architectures.
+ *  Intel 386, DEC ALPHA and x86-64 architectures.
  */
 
 /*
@@ -195,4 +195,50 @@
 #define StartupPCState	(S3/8-1)
 #endif // HOST_ALPHA
 
+#ifdef HOST_x86_64
+
+/* SWITCH is called like any other routine, so the compiler has already
+ * saved whatever it needs of the registers a routine may change; only
+ * the ones it must preserve (callee-saved: rbx, rbp, r12-r15) and the
+ * stack pointer are saved.  The return address stays on the stack.
+ * These are the offsets from the beginning of the Thread object, in
+ * bytes, used in switch.s
+ */
+#define _RSP     0
+#define _RBX     8
+#define _RBP    16
+#define _R12    24
+#define _R13    32
+#define _R14    40
+#define _R15    48
+#define _PC     56	/* used by SWITCH only with SAVE_ALL (below) */
+
+/* Built with SAVE_ALL ("make HOST64=1 SAVEALL=1"), SWITCH also saves the
+ * caller-saved registers and copies the return address through _PC, as
+ * the i386 SWITCH does, to compare the two with -sb.
+ */
+#define _RAX    64
+#define _RCX    72
+#define _RDX    80
+#define _RSI    88
+#define _RDI    96
+#define _R8    104
+#define _R9    112
+#define _R10   120
+#define _R11   128
+
+/* These definitions are used in Thread::StackAllocate(). */
+#define PCState         (_PC/8-1)
+#define FPState         (_RBP/8-1)
+#define InitialPCState  (_R12/8-1)
+#define InitialArgState (_R13/8-1)
+#define WhenDonePCState (_R14/8-1)
+#define StartupPCState  (_R15/8-1)
+
+#define InitialPC       %r12
+#define InitialArg      %r13
+#define WhenDonePC      %r14
+#define StartupPC       %r15
+#endif // HOST_x86_64
+
 #endif // SWITCH_H
@@ -11,6 +11,7 @@
  *	    HP PA-RISC
  *	    Intel 386
  *	    DEC ALPHA
+ *	    x86-64
  *
  * We define two routines for each architecture:
  *
@@ -415,3 +416,89 @@ SWITCH:
 	.end SWITCH
 
 #endif // HOST_ALPHA
+
+#ifdef HOST_x86_64
+
+        .text
+        .align  16
+
+        .globl  ThreadRoot
+
+/* void ThreadRoot( void )
+**
+** SWITCH returns here the first time the thread runs, with the stack
+** aligned to 16 bytes as a call needs (see Thread::StackAllocate).
+** expects the following registers to be initialized:
+**      r15     points to startup function (interrupt enable)
+**      r13     contains inital argument to thread function
+**      r12     points to thread function
+**      r14     point to Thread::Finish()
+*/
+ThreadRoot:
+        xorl    %ebp,%ebp               # outermost frame, for debuggers
+        call    *StartupPC
+        movq    InitialArg,%rdi
+        call    *InitialPC
+        call    *WhenDonePC
+
+        # NOT REACHED
+        hlt
+
+/* void SWITCH( thread *t1, thread *t2 )
+**
+** on entry, t1 is in rdi and t2 in rsi, and the return address is on
+** top of the stack of t1.  Only the callee-saved registers and the
+** stack pointer are saved; SWITCH returns to the address on top of the
+** stack of t2.  With SAVE_ALL every register is saved, and the return
+** address goes through _PC (see switch.h).
+*/
+        .align  16
+        .globl  SWITCH
+SWITCH:
+#ifdef SAVE_ALL
+        movq    %rax,_RAX(%rdi)         # save caller-saved registers
+        movq    %rcx,_RCX(%rdi)
+        movq    %rdx,_RDX(%rdi)
+        movq    %rsi,_RSI(%rdi)
+        movq    %rdi,_RDI(%rdi)
+        movq    %r8,_R8(%rdi)
+        movq    %r9,_R9(%rdi)
+        movq    %r10,_R10(%rdi)
+        movq    %r11,_R11(%rdi)
+        movq    0(%rsp),%rax            # get return address from stack
+        movq    %rax,_PC(%rdi)          # save it into the pc storage
+#endif
+        movq    %rsp,_RSP(%rdi)         # save stack pointer
+        movq    %rbx,_RBX(%rdi)         # save callee-saved registers
+        movq    %rbp,_RBP(%rdi)
+        movq    %r12,_R12(%rdi)
+        movq    %r13,_R13(%rdi)
+        movq    %r14,_R14(%rdi)
+        movq    %r15,_R15(%rdi)
+
+        movq    _RSP(%rsi),%rsp         # restore stack pointer
+        movq    _RBX(%rsi),%rbx         # restore callee-saved registers
+        movq    _RBP(%rsi),%rbp
+        movq    _R12(%rsi),%r12
+        movq    _R13(%rsi),%r13
+        movq    _R14(%rsi),%r14
+        movq    _R15(%rsi),%r15
+#ifdef SAVE_ALL
+        movq    _PC(%rsi),%rax          # restore return address
+        movq    %rax,0(%rsp)            # copy it over the one on the stack
+        movq    _RAX(%rsi),%rax         # restore caller-saved registers
+        movq    _RCX(%rsi),%rcx
+        movq    _RDX(%rsi),%rdx
+        movq    _RDI(%rsi),%rdi
+        movq    _R8(%rsi),%r8
+        movq    _R9(%rsi),%r9
+        movq    _R10(%rsi),%r10
+        movq    _R11(%rsi),%r11
+        movq    _RSI(%rsi),%rsi         # last: rsi points to t2
+#endif
+
+        ret
+
+        .section .note.GNU-stack,"",@progbits
+
+#endif // HOST_x86_64
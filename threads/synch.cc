@@ -37,7 +37,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List;
+    queue = new DList<Thread>(&Thread::queueLink);
 }
 
 //----------------------------------------------------------------------
@@ -67,7 +67,7 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     
     while (value == 0) { 			// semaphore not available
-	queue->Append((void *)currentThread);	// so go to sleep
+	queue->Append(currentThread);		// so go to sleep
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
@@ -90,7 +90,7 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = (Thread *)queue->Remove();     // remove the front thread from the waiting queue
+    thread = queue->Remove();     // remove the front thread from the waiting queue
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	    scheduler->ReadyToRun(thread);
     value++;
@@ -179,7 +179,7 @@ bool Lock::isHeldByCurrentThread()
 Condition::Condition(char* debugName) 
 { 
     name = debugName;
-    queue = new List;
+    queue = new DList<Thread>(&Thread::queueLink);
     lock = NULL;
 }
 
@@ -234,7 +234,7 @@ void Condition::Signal(Lock* conditionLock)
     ASSERT(conditionLock->isHeldByCurrentThread());
     if(!queue->IsEmpty()) {
 	ASSERT(lock == conditionLock);
-	nextThread = (Thread *)queue->Remove();
+	nextThread = queue->Remove();
 	scheduler->ReadyToRun(nextThread);      // wake up the thread
     } 
     (void) interrupt->SetLevel(oldLevel);
@@ -255,7 +255,7 @@ void Condition::Broadcast(Lock* conditionLock)
     ASSERT(conditionLock->isHeldByCurrentThread());
     if(!queue->IsEmpty()) {
 	ASSERT(lock == conditionLock);
-	while((nextThread = (Thread *)queue->Remove()) != NULL) {
+	while((nextThread = queue->Remove()) != NULL) {
 	    scheduler->ReadyToRun(nextThread);  // wake up the thread
 	}
     } 
@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "dlist.h"
 
 
 // The following class defines a "semaphore" whose value is a non-negative
@@ -49,7 +50,7 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    DList<Thread> *queue;	// threads waiting in P() for the value to be > 0
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -133,7 +134,7 @@ class Condition {
 
   private:
     char* name;
-    List* queue;  // threads waiting on the condition
+    DList<Thread>* queue;  // threads waiting on the condition
     Lock* lock;   // debugging aid:  used to check correctness of
                   // arguments to Wait, Signal and Broacast
 };
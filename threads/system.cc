@@ -18,6 +18,11 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+EventLog *eventLog;			// log of the events from outside
+					// of Nachos, or NULL
+Alarm *alarmClock;			// threads sleeping until a time
+SchedStats *schedStats;			// scheduler statistics, or NULL
+Tracer *tracer;				// kernel event trace, or NULL
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -29,6 +34,7 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+Profiler *profiler;	// user program profile, or NULL
 #endif
 
 #ifdef NETWORK
@@ -54,13 +60,17 @@ extern void Cleanup();
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	Under the multilevel feedback queue or stride scheduling, the
+//	scheduler decides whether the interrupted thread has had its time
+//	(Scheduler::TimerTick).
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(_int dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    if ((interrupt->getStatus() != IdleMode) && scheduler->TimerTick())
 	interrupt->YieldOnReturn();
 }
 
@@ -80,9 +90,17 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    char *eventLogName = NULL;		// -record or -replay
+    bool replay = FALSE;
+    SchedPolicy policy = PrioritySched;	// -sched
+    bool schedStatsOn = FALSE;		// -schedstats
+    char *schedStatsName = NULL;	// and the file to write them to
+    char *traceName = NULL;		// -trace
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    bool threadedCode = FALSE;	// use the threaded-code engine
+    bool profiling = FALSE;	// count user instructions by address
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -108,10 +126,78 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sched")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "priority"))
+		policy = PrioritySched;
+	    else if (!strcmp(*(argv + 1), "mlfq"))
+		policy = MLFQSched;	// multilevel feedback queue
+	    else if (!strcmp(*(argv + 1), "stride"))
+		policy = StrideSched;	// shares in proportion to tickets
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+	    ASSERT(argc > 1);
+	    eventLogName = *(argv + 1);
+	    replay = !strcmp(*argv, "-replay");
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-schedstats")) {
+	    schedStatsOn = TRUE;
+	    if ((argc > 1) && (**(argv + 1) != '-')) {
+		schedStatsName = *(argv + 1);	// write them to this file
+		argCount = 2;
+	    }
+	} else if (!strcmp(*argv, "-trace")) {
+	    ASSERT(argc > 1);
+	    traceName = *(argv + 1);
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	if (!strcmp(*argv, "-tc"))
+	    threadedCode = TRUE;
+	if (!strcmp(*argv, "-prof"))
+	    profiling = TRUE;
+	if (!strcmp(*argv, "-hostorder"))
+	    HostOrderMemory = TRUE;	// keep memory in host byte order
+	if (!strcmp(*argv, "-bigendian"))
+	    BigEndianMemory = TRUE;	// keep memory big-endian
+	if (!strcmp(*argv, "-cost")) {		// charge instructions by kind
+	    if ((argc > 1) && (**(argv + 1) != '-')) {
+		SetCosts(*(argv + 1));		// with these costs changed
+		argCount = 2;
+	    } else
+		SetCosts(NULL);
+	}
+	if (!strcmp(*argv, "-mem")) {
+	    ASSERT(argc > 1);
+	    NumPhysPages = atoi(*(argv + 1));	// size of physical memory,
+	    argCount = 2;			// in pages
+	}
+	if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    TLBSize = atoi(*(argv + 1));
+	    argCount = 2;
+	}
+	if (!strcmp(*argv, "-tlbassoc")) {
+	    ASSERT(argc > 1);
+	    TLBAssoc = atoi(*(argv + 1));	// entries per set
+	    argCount = 2;
+	}
+	if (!strcmp(*argv, "-tlbpolicy")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "random"))
+		TLBReplacement = TLBRandom;
+	    else if (!strcmp(*(argv + 1), "fifo"))
+		TLBReplacement = TLBFifo;
+	    else if (!strcmp(*(argv + 1), "plru"))
+		TLBReplacement = TLBPseudoLRU;
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -136,10 +222,20 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    eventLog = NULL;
+    if (eventLogName != NULL)			// log external events, or
+	eventLog = new EventLog(eventLogName, replay);	// play them back
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
+    scheduler = new Scheduler(policy);		// initialize the ready queue
+    if (randomYield || (policy != PrioritySched))	// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    alarmClock = new Alarm;			// no interrupt until it is used
+    schedStats = NULL;
+    if (schedStatsOn)				// keep scheduler statistics
+	schedStats = new SchedStats(schedStatsName);
+    tracer = NULL;
+    if (traceName != NULL)			// record kernel events
+	tracer = new Tracer(traceName);
 
     threadToBeDestroyed = NULL;
 
@@ -153,7 +249,10 @@ Initialize(int argc, char **argv)
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);	// this must come first
+    machine = new Machine(debugUserProg, threadedCode);	// this must come first
+    profiler = NULL;
+    if (profiling)
+	profiler = new Profiler(MemorySize);	// no address space is bigger
 #endif
 
 #ifdef FILESYS
@@ -185,6 +284,7 @@ Cleanup()
 #ifdef USER_PROGRAM
     DEBUG('s', "delete machine\n");
     delete machine;
+    delete profiler;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -198,6 +298,14 @@ Cleanup()
 #endif
     DEBUG('s', "delete timer\n");
     delete timer;
+    DEBUG('s', "delete alarm clock\n");
+    delete alarmClock;
+    DEBUG('s', "delete scheduler statistics\n");
+    delete schedStats;
+    DEBUG('s', "delete tracer\n");
+    delete tracer;
+    DEBUG('s', "delete event log\n");
+    delete eventLog;
     DEBUG('s', "delete scheduler\n");
     delete scheduler;
     DEBUG('s', "delete interrupt\n");
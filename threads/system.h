@@ -15,6 +15,10 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "eventlog.h"
+#include "alarm.h"
+#include "schedstats.h"
+#include "trace.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -28,10 +32,18 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern EventLog *eventLog;			// external events, if -record
+						// or -replay
+extern Alarm *alarmClock;			// threads sleeping until a time
+extern SchedStats *schedStats;			// scheduler statistics, if
+						// -schedstats
+extern Tracer *tracer;				// kernel events, if -trace
 
 #ifdef USER_PROGRAM
 #include "machine.h"
 extern Machine* machine;	// user program memory and registers
+#include "profile.h"
+extern Profiler *profiler;	// user program profile, if -prof
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -33,12 +33,23 @@
 //----------------------------------------------------------------------
 
 Thread::Thread(char* threadName) {
-    name = threadName;
+    strcpy(name, threadName);
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    priority = DefaultPriority;
+    ticksUsed = quantumUsed = waitTicks = dispatches = 0;
+    boostEpoch = firstReady = responseTicks = -1;
+    tickets = DefaultTickets;
+    pass = 0;
+    shareStart = -1;
+    entitledTicks = 0;
+    readySince = 0;
+    schedId = -1;
+    traceId = -1;
 #ifdef USER_PROGRAM
     pcb = new PCB();
+    lastCPU = -1;
 #endif
 }
 
@@ -66,6 +77,43 @@ Thread::~Thread() {
 #endif
 }
 
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	删除的Thread对象挂在空闲链表上(用对象的第一个字做链接), new时
+//	优先从中取出重用; 和线程栈池(AllocBoundedArray)一起, 使反复的
+//	Fork/Finish在稳定后不再向堆或UNIX申请空间.
+//	和线程栈池一样, 链表上至多留MaxPooledObjects个对象, 再多的还给堆,
+//	以免一时有大量线程结束后空间一直被占着.
+//----------------------------------------------------------------------
+
+#define MaxPooledObjects 64             // 每个空闲链表上至多留这么多对象
+
+static void *freeThreads = NULL;        // 已删除的Thread对象
+static int numFreeThreads = 0;          // freeThreads上的对象数
+
+void *
+Thread::operator new(size_t size) {
+    void *p = freeThreads;
+
+    ASSERT(size == sizeof(Thread));
+    if (p == NULL)
+        return ::operator new(size);
+    freeThreads = *(void **) p;
+    numFreeThreads--;
+    return p;
+}
+
+void
+Thread::operator delete(void *p) {
+    if (numFreeThreads == MaxPooledObjects) {
+        ::operator delete(p);
+        return;
+    }
+    *(void **) p = freeThreads;
+    freeThreads = p;
+    numFreeThreads++;
+}
+
 //----------------------------------------------------------------------
 // Thread::Fork
 // 	Invoke (*func)(arg), allowing caller and callee to execute 
@@ -88,7 +136,7 @@ Thread::~Thread() {
 
 void 
 Thread::Fork(VoidFunctionPtr func, _int arg) {
-#ifdef HOST_ALPHA
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
     DEBUG('t', "Forking thread \"%s\" with func = 0x%lx, arg = %ld\n",
 	  name, (long) func, arg);
 #else
@@ -149,6 +197,9 @@ void
 Thread::Finish () {
     (void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
+    scheduler->Finished(this);          // 计入调度统计
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "finish", NULL, 0);
 #ifdef USER_PROGRAM
     // step 1: 获取waitingList
     List *waitingList = scheduler->getWaitingList();
@@ -173,11 +224,12 @@ Thread::Finish () {
 
 //----------------------------------------------------------------------
 // Thread::Yield
-// 	Relinquish the CPU if any other thread is ready to run.
-//	If so, put the thread on the end of the ready list, so that
-//	it will eventually be re-scheduled.
+// 	Relinquish the CPU if any other thread of the same or a higher
+//	priority (under stride scheduling, with no larger a pass) is ready
+//	to run.  If so, put the thread on the end of the ready list for
+//	its priority, so that it will eventually be re-scheduled.
 //
-//	NOTE: returns immediately if no other thread on the ready queue.
+//	NOTE: returns immediately if no such thread is on the ready queue.
 //	Otherwise returns when the thread eventually works its way
 //	to the front of the ready list and gets re-scheduled.
 //
@@ -198,7 +250,15 @@ Thread::Yield () {
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     
-    nextThread = scheduler->FindNextToRun();
+    if (scheduler->ShouldYield())
+	nextThread = scheduler->FindNextToRun();
+    else
+	nextThread = NULL;		// only less important threads are ready
+    if (schedStats != NULL)
+	schedStats->Yielded(this, nextThread != NULL);
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "yield",
+			"switched", nextThread != NULL);
     if (nextThread != NULL) {
 	scheduler->ReadyToRun(this);
 	scheduler->Run(nextThread);
@@ -206,6 +266,29 @@ Thread::Yield () {
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	改变线程的优先级.  就绪的线程从原优先级的队列中取出, 放到新优先级
+//	队列的末尾; 若它因此比当前线程更重要, 由Scheduler::ReadyToRun
+//	安排抢占.  当前线程降低自己的优先级后不会自动让出CPU, 需要时
+//	由调用者Yield.
+//
+//	"newPriority" -- 0(最高)到NumPriorities - 1(最低)
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int newPriority) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(newPriority >= 0 && newPriority < NumPriorities);
+    if (status == READY && scheduler->RemoveReady(this)) {
+        priority = newPriority;
+        scheduler->ReadyToRun(this);
+    } else
+        priority = newPriority;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 // 	Relinquish the CPU, because the current thread is blocked
@@ -235,12 +318,32 @@ Thread::Sleep () {
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
+    scheduler->Blocked(this);
+    if (tracer != NULL)
+	tracer->Instant(tracer->ThreadTrack(this), "thread", "sleep", NULL, 0);
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
 	    interrupt->Idle();	// no one to run, wait for an interrupt
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepUntil
+// 	Relinquish the CPU until the time (stats->totalTicks) is "when",
+//	instead of yielding again and again until then.  The thread waits
+//	in the alarm clock, which wakes it up with an interrupt (see
+//	alarm.h).  Returns at once if the time has come already.
+//
+//	"when" is the time to wake up at.
+//----------------------------------------------------------------------
+
+void
+Thread::SleepUntil(int when)
+{
+    ASSERT(this == currentThread);
+    alarmClock->WaitUntil(when);
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -278,8 +381,17 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg) {
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
     stackTop = stack + StackSize - 96;
-#else  // HOST_MIPS  || HOST_i386 || HOST_ALPHA
+#else  // HOST_MIPS  || HOST_i386 || HOST_ALPHA || HOST_x86_64
     stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+#ifdef HOST_x86_64
+    // SWITCH for x86-64 leaves the return address on the stack instead
+    // of saving it in machineState[PCState], so the thread's first
+    // return, to ThreadRoot, is put on its stack here.  stackTop is
+    // 16-byte aligned, so ThreadRoot starts with the stack aligned as
+    // the calls it makes need.
+    stackTop -= sizeof(_int) / sizeof(int);
+    *(_int *) stackTop = (_int) ThreadRoot;
+#endif
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -373,6 +485,37 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg) {
 #ifdef USER_PROGRAM
 #include "machine.h"
 
+//----------------------------------------------------------------------
+// PCB::operator new, PCB::operator delete
+// 	同Thread, 删除的PCB对象留在空闲链表上重用, 至多MaxPooledObjects个.
+//----------------------------------------------------------------------
+
+static void *freePCBs = NULL;           // 已删除的PCB对象
+static int numFreePCBs = 0;             // freePCBs上的对象数
+
+void *
+PCB::operator new(size_t size) {
+    void *p = freePCBs;
+
+    ASSERT(size == sizeof(PCB));
+    if (p == NULL)
+        return ::operator new(size);
+    freePCBs = *(void **) p;
+    numFreePCBs--;
+    return p;
+}
+
+void
+PCB::operator delete(void *p) {
+    if (numFreePCBs == MaxPooledObjects) {
+        ::operator delete(p);
+        return;
+    }
+    *(void **) p = freePCBs;
+    freePCBs = p;
+    numFreePCBs++;
+}
+
 //----------------------------------------------------------------------
 // PCB::SaveUserState
 //	Save the CPU state of a user program on a context switch.
@@ -11,6 +11,11 @@
 
 #include "copyright.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "addrspace.h"
+#endif
+
+#include <sys/time.h>
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -49,3 +54,120 @@ ThreadTest()
     SimpleThread(0);
 }
 
+
+//----------------------------------------------------------------------
+// SwitchThread
+// 	Yield the CPU "benchYields" times, for SwitchBench.
+//
+//	"which" is simply a number identifying the thread.
+//----------------------------------------------------------------------
+
+static int benchYields;			// # of times each thread yields
+
+static void
+SwitchThread(_int which)
+{
+    for (int i = 0; i < benchYields; i++)
+	currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// SwitchBench
+// 	Time a ping-pong of about "switches" context switches between two
+//	threads that do nothing but Yield to each other, and print how
+//	many switches the host does in a second.  Run it on Nachos built
+//	with one SWITCH (or scheduler) and then another, to compare them.
+//
+//	If "program" is not NULL, the address space of that user program
+//	is loaded, though not run, and the thread running SwitchBench
+//	takes it, so that each switch is between a user thread and a
+//	kernel thread, and the scheduler's saving and restoring of the
+//	user registers is timed too.
+//----------------------------------------------------------------------
+
+void
+SwitchBench(int switches, char *program)
+{
+    Thread *t = new Thread("switch bench");
+    struct timeval start, end;
+    double seconds;
+#ifdef USER_PROGRAM
+    AddrSpace *space = NULL;
+
+    if (program != NULL) {
+	OpenFile *executable = fileSystem->Open(program);
+
+	if (executable == NULL) {
+	    printf("Unable to open file %s\n", program);
+	    return;
+	}
+	space = new AddrSpace(executable);
+	delete executable;
+	currentThread->pcb->space = space;
+	space->InitRegisters();
+	space->RestoreState();
+    }
+#else
+    ASSERT(program == NULL);
+#endif
+
+    benchYields = (switches + 1) / 2;
+    gettimeofday(&start, NULL);
+    t->Fork(SwitchThread, 1);
+    SwitchThread(0);			// the other thread yields once
+					// less before we get back here
+    gettimeofday(&end, NULL);
+    switches = 2 * benchYields - 1;
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    printf("%d context switches%s in %.3f seconds: %.0f switches/second\n",
+	switches, (program != NULL) ? " with a user thread" : "", seconds,
+	(seconds > 0) ? switches / seconds : 0);
+#ifdef USER_PROGRAM
+    if (space != NULL) {
+	currentThread->pcb->space = NULL;
+	delete space;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// SleepThread
+// 	Sleep three times, "which" * 1000 ticks each time, for AlarmTest,
+//	printing when the thread wakes up and when it meant to.
+//
+//	"which" is simply a number identifying the thread.
+//----------------------------------------------------------------------
+
+static void
+SleepThread(_int which)
+{
+    int when;
+
+    for (int i = 0; i < 3; i++) {
+	when = stats->totalTicks + (int) which * 1000;
+	currentThread->SleepUntil(when);
+	printf("*** thread %d woke up at %d (due at %d)\n", (int) which,
+	    stats->totalTicks, when);
+    }
+}
+
+//----------------------------------------------------------------------
+// AlarmTest
+// 	Fork "threads" threads that sleep in the alarm clock, each for its
+//	own delay, the first forked for the longest.  They should wake up
+//	in the order of their times, not the order they went to sleep in,
+//	each as soon as it is due; since no thread is ready meanwhile, the
+//	clock skips to that time, and the ticks are nearly all idle.
+//----------------------------------------------------------------------
+
+void
+AlarmTest(int threads)
+{
+    char *name;
+
+    for (int i = threads; i > 0; i--) {
+	name = new char[20];
+	sprintf(name, "sleeper %d", i);
+	(new Thread(name))->Fork(SleepThread, i);
+    }
+}
@@ -0,0 +1,271 @@
+// trace.cc
+//	Routines to record kernel events in a ring, and to write them out
+//	as Chrome trace events.  See trace.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+// The names of the device tracks, in the order of TraceTrack.
+
+static const char *deviceNames[] = { "interrupts", "disk", "network" };
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Start tracing: allocate the ring, which holds no events yet.
+//
+//	"name" is the UNIX file to write the events to when Nachos halts.
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *name)
+{
+    ring = new TraceEvent[TraceRingSize];
+    next = 0;
+    numEvents = 0;
+    maxThreads = 16;
+    threadNames = new char[maxThreads][32];
+    numThreads = 0;
+    fileName = name;
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	De-allocate the ring and the thread names.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer()
+{
+    delete [] ring;
+    delete [] threadNames;
+}
+
+//----------------------------------------------------------------------
+// Tracer::ThreadTrack
+// 	Return the track of a thread; the first time, give it a number
+//	(Thread::traceId) and keep its name, the array growing if need be.
+//	The name is kept because the thread may be gone by the time the
+//	events are written.
+//
+//	"thread" is the thread to look up.
+//----------------------------------------------------------------------
+
+int
+Tracer::ThreadTrack(Thread *thread)
+{
+    if (thread->traceId < 0) {
+	if (numThreads == maxThreads) {
+	    char (*bigger)[32] = new char[maxThreads * 2][32];
+
+	    for (int i = 0; i < numThreads; i++)
+		strcpy(bigger[i], threadNames[i]);
+	    delete [] threadNames;
+	    threadNames = bigger;
+	    maxThreads *= 2;
+	}
+	thread->traceId = numThreads++;
+	strncpy(threadNames[thread->traceId], thread->getName(), 31);
+	threadNames[thread->traceId][31] = '\0';
+    }
+    return NumDeviceTracks + thread->traceId;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Record
+// 	Return the place in the ring for a new event, filled in with the
+//	current time and the given fields and no argument.  When the ring
+//	is full, the oldest event is overwritten.
+//----------------------------------------------------------------------
+
+TraceEvent *
+Tracer::Record(int track, char phase, const char *category,
+	       const char *name)
+{
+    TraceEvent *e = &ring[next];
+
+    next = (next + 1) & (TraceRingSize - 1);
+    numEvents++;
+    e->name = name;
+    e->category = category;
+    e->argName = NULL;
+    e->arg = 0;
+    e->when = stats->totalTicks;
+    e->duration = 0;
+    e->track = track;
+    e->phase = phase;
+    return e;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Begin, Tracer::End
+// 	Record the beginning, or the end, of a slice of time on a track.
+//	Slices on the same track must nest.
+//----------------------------------------------------------------------
+
+void
+Tracer::Begin(int track, const char *category, const char *name)
+{
+    (void) Record(track, 'B', category, name);
+}
+
+void
+Tracer::End(int track, const char *category, const char *name)
+{
+    (void) Record(track, 'E', category, name);
+}
+
+//----------------------------------------------------------------------
+// Tracer::Complete
+// 	Record a slice of time that begins now, whose length is already
+//	known, as for a disk request.
+//
+//	"duration" is its length in ticks.
+//	"argName", "arg" are a number to show with it ("argName" NULL if
+//	none).
+//----------------------------------------------------------------------
+
+void
+Tracer::Complete(int track, const char *category, const char *name,
+		 int duration, const char *argName, int arg)
+{
+    TraceEvent *e = Record(track, 'X', category, name);
+
+    e->duration = duration;
+    e->argName = argName;
+    e->arg = arg;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Instant
+// 	Record something that happens now, and takes no time.
+//
+//	"argName", "arg" are a number to show with it ("argName" NULL if
+//	none).
+//----------------------------------------------------------------------
+
+void
+Tracer::Instant(int track, const char *category, const char *name,
+		const char *argName, int arg)
+{
+    TraceEvent *e = Record(track, 'i', category, name);
+
+    e->argName = argName;
+    e->arg = arg;
+}
+
+//----------------------------------------------------------------------
+// WriteName
+// 	Write a string as a JSON string, quoting the characters that need
+//	it.
+//----------------------------------------------------------------------
+
+static void
+WriteName(FILE *file, const char *name)
+{
+    fputc('"', file);
+    for (const char *c = name; *c != '\0'; c++) {
+	if (*c == '"' || *c == '\\')
+	    fprintf(file, "\\%c", *c);
+	else if ((unsigned char) *c < ' ')
+	    fprintf(file, "\\u%04x", *c);
+	else
+	    fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+//----------------------------------------------------------------------
+// WriteMetadata
+// 	Write an event that names a process (pid 1 holds the threads, and
+//	pid 2 the devices) or a track.  Every event but the first in the
+//	list is written after a comma.
+//----------------------------------------------------------------------
+
+static void
+WriteMetadata(FILE *file, bool first, const char *what, int pid,
+	      int tid, const char *name)
+{
+    fprintf(file, "%s{\"ph\": \"M\", \"name\": \"%s\", \"pid\": %d, "
+	"\"tid\": %d, \"args\": {\"name\": ", first ? "" : ",\n", what,
+	pid, tid);
+    WriteName(file, name);
+    fprintf(file, "}}");
+}
+
+//----------------------------------------------------------------------
+// Tracer::Write
+// 	Write the events in the ring, oldest first, to the UNIX file given
+//	to the constructor, in the JSON object format of Chrome trace
+//	events: the names of the processes and tracks come first, and the
+//	number of events lost goes in "otherData".
+//
+//	When the ring has wrapped, the beginning of a slice may have been
+//	overwritten while its end was kept.  Slices on a track nest, and
+//	the events lost are the oldest, so such an end is one that comes
+//	when no slice is open on its track; it is left out, and counted
+//	as lost.
+//----------------------------------------------------------------------
+
+void
+Tracer::Write()
+{
+    FILE *file = fopen(fileName, "w");
+    long long dropped = 0;
+    int first = 0, count = (int) numEvents;
+    int *depth;				// # of slices open on each track
+    TraceEvent *e;
+
+    if (file == NULL) {
+	perror(fileName);
+	return;
+    }
+    if (numEvents > TraceRingSize) {
+	dropped = numEvents - TraceRingSize;
+	first = next;
+	count = TraceRingSize;
+    }
+    depth = new int[NumDeviceTracks + numThreads];
+    for (int i = 0; i < NumDeviceTracks + numThreads; i++)
+	depth[i] = 0;
+    fprintf(file, "{\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n");
+    WriteMetadata(file, TRUE, "process_name", 1, 0, "threads");
+    WriteMetadata(file, FALSE, "process_name", 2, 0, "devices");
+    for (int i = 0; i < NumDeviceTracks; i++)
+	WriteMetadata(file, FALSE, "thread_name", 2, i, deviceNames[i]);
+    for (int i = 0; i < numThreads; i++)
+	WriteMetadata(file, FALSE, "thread_name", 1, NumDeviceTracks + i,
+		      threadNames[i]);
+    for (int i = 0; i < count; i++) {
+	e = &ring[(first + i) & (TraceRingSize - 1)];
+	if (e->phase == 'B')
+	    depth[e->track]++;
+	else if (e->phase == 'E') {
+	    if (depth[e->track] == 0) {	// its beginning was overwritten
+		dropped++;
+		continue;
+	    }
+	    depth[e->track]--;
+	}
+	fprintf(file, ",\n{\"ph\": \"%c\", \"cat\": \"%s\", \"name\": ",
+	    e->phase, e->category);
+	WriteName(file, e->name);
+	fprintf(file, ", \"ts\": %d, \"pid\": %d, \"tid\": %d", e->when,
+	    (e->track < NumDeviceTracks) ? 2 : 1, e->track);
+	if (e->phase == 'X')
+	    fprintf(file, ", \"dur\": %d", e->duration);
+	else if (e->phase == 'i')
+	    fprintf(file, ", \"s\": \"t\"");
+	if (e->argName != NULL)
+	    fprintf(file, ", \"args\": {\"%s\": %d}", e->argName, e->arg);
+	fprintf(file, "}");
+    }
+    fprintf(file, "\n],\n\"otherData\": {\"ticks\": %d, \"events\": %lld, "
+	"\"dropped\": %lld}}\n", stats->totalTicks, numEvents, dropped);
+    fclose(file);
+    delete [] depth;
+    printf("Trace: %lld events, %lld lost, written to %s\n", numEvents,
+	dropped, fileName);
+}
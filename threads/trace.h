@@ -0,0 +1,88 @@
+// trace.h
+//	Data structures for tracing what the kernel does (-trace): the
+//	threads going to sleep, yielding and finishing, the interrupt
+//	handlers, the disk requests, the system calls and the network
+//	messages sent and received.
+//
+//	The events are written, when Nachos halts, as Chrome trace events
+//	in JSON, which chrome://tracing and the Perfetto UI can show on a
+//	time line, one track for each thread and each device.  Times are
+//	simulated ticks, shown as microseconds.
+//
+//	While Nachos runs, an event is only copied into a ring that is
+//	allocated at the start, so tracing does no I/O and takes no
+//	simulated time (it allocates memory only for the name of each new
+//	thread), and the workload runs as it would without it.  If more
+//	events happen than fit, the oldest are lost; the end of a slice
+//	whose beginning was lost is not written either.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define TraceRingSize	65536		// # of events kept; a power of 2
+
+// The tracks of the devices; thread i has track NumDeviceTracks + i.
+
+enum TraceTrack { TraceInterrupts, TraceDisk, TraceNetwork, NumDeviceTracks };
+
+// An event, as it is kept in the ring.  The strings are not copied,
+// so they must be constants.
+
+struct TraceEvent {
+    const char *name;			// what happened
+    const char *category;		// kind of event, e.g. "syscall"
+    const char *argName;		// name of "arg", or NULL for none
+    int arg;				// a number to show with the event
+    int when;				// stats->totalTicks when it happened
+    int duration;			// for a complete event, how long
+    short track;			// the thread or device
+    char phase;				// 'B'egin, 'E'nd, 'X' (complete) or
+					// 'i'nstant, as in the JSON
+};
+
+// The following class defines the tracer.
+
+class Tracer {
+  public:
+    Tracer(char *fileName);		// start tracing, to write the events
+					// to this UNIX file at the end
+    ~Tracer();
+
+    int ThreadTrack(Thread *thread);	// the track of a thread
+
+    void Begin(int track, const char *category, const char *name);
+					// a slice begins on a track
+    void End(int track, const char *category, const char *name);
+					// and ends
+    void Complete(int track, const char *category, const char *name,
+		  int duration, const char *argName, int arg);
+					// a slice that starts now and is
+					// known to last "duration" ticks
+    void Instant(int track, const char *category, const char *name,
+		 const char *argName, int arg);	// something happens now
+
+    void Write();			// write the events to the file
+
+  private:
+    TraceEvent *ring;			// the last TraceRingSize events
+    int next;				// where the next event goes
+    long long numEvents;		// # of events ever recorded
+    char (*threadNames)[32];		// name of each thread seen, by
+					// Thread::traceId, maybe cut short
+    int numThreads;			// # of threads seen
+    int maxThreads;			// size of the "threadNames" array
+    char *fileName;			// where to write the events
+
+    TraceEvent *Record(int track, char phase, const char *category,
+		       const char *name);	// the next place in the ring,
+					// filled in
+};
+
+#endif // TRACE_H
@@ -25,8 +25,10 @@
 
 #include "copyright.h"
 
-#ifdef HOST_ALPHA		// Needed because of gcc uses 64 bit pointers and
-#define _int long		// 32 bit integers on the DEC ALPHA architecture.
+#if defined(HOST_ALPHA) || defined(HOST_x86_64)
+				// Needed because of gcc uses 64 bit pointers and
+#define _int long		// 32 bit integers on the DEC ALPHA architecture,
+				// as on x86-64.
 #else
 #define _int int
 #endif
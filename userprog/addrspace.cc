@@ -75,10 +75,11 @@ AddrSpace::AddrSpace(OpenFile *executable)
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+    ASSERT(numPages <= (unsigned) NumPhysPages);	// check we're not
+							// trying to run anything
+							// too big -- at least
+							// until we have virtual
+							// memory
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
 					numPages, size);
@@ -98,6 +99,8 @@ AddrSpace::AddrSpace(OpenFile *executable)
 // zero out the entire address space, to zero the unitialized data segment 
 // and the stack segment
     bzero(machine->mainMemory, size);
+    for (i = 0; i < numPages; i++)
+	machine->InvalidateDecodedFrame(pageTable[i].physicalPage);
 
 // then, copy in the code and data segments into memory
     if (noffH.code.size > 0) {
@@ -105,12 +108,14 @@ AddrSpace::AddrSpace(OpenFile *executable)
 			noffH.code.virtualAddr, noffH.code.size);
         executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
 			noffH.code.size, noffH.code.inFileAddr);
+        machine->ConvertLoadedImage(noffH.code.virtualAddr, noffH.code.size);
     }
     if (noffH.initData.size > 0) {
         DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
 			noffH.initData.virtualAddr, noffH.initData.size);
         executable->ReadAt(&(machine->mainMemory[noffH.initData.virtualAddr]),
 			noffH.initData.size, noffH.initData.inFileAddr);
+        machine->ConvertLoadedImage(noffH.initData.virtualAddr, noffH.initData.size);
     }
 
 }
@@ -181,6 +186,7 @@ void AddrSpace::RestoreState()
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->FlushTranslationCache();
 }
 
 void AddrSpace::Print() {
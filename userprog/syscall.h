@@ -29,6 +29,22 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_SetPriority	11
+#define SC_ExecShare	12
+
+/* Priorities, for SetPriority: the lower the number, the more important
+ * the process (the kernel's NumPriorities and DefaultPriority, in
+ * thread.h, must agree)
+ */
+#define HighestPriority	0
+#define NormalPriority	16
+#define LowestPriority	31
+
+/* Tickets, for ExecShare: under stride scheduling (-sched stride), each
+ * process gets a share of the CPU in proportion to its tickets, from 1 
+ * to 10000 (the kernel's DefaultTickets and MaxTickets, in thread.h)
+ */
+#define NormalTickets	100
 
 #ifndef IN_ASM
 
@@ -58,6 +74,12 @@ typedef int SpaceId;
  * address space identifier
  */
 SpaceId Exec(char *name);
+
+/* Like Exec, but give the new process "tickets" tickets instead of
+ * NormalTickets, for its share of the CPU.  Return -1 if "tickets"
+ * is out of range.
+ */
+SpaceId ExecShare(char *name, int tickets);
  
 /* Only return once the the user program "id" has finished.  
  * Return the exit status.
@@ -124,6 +146,14 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+/* Set the priority of the calling process.  Of the processes that are
+ * ready to run, the one of the highest priority runs first, so an 
+ * interactive program can make itself more important than programs
+ * that compute.  Processes start at NormalPriority.  Return the old
+ * priority, or -1 if "priority" is out of range.
+ */
+int SetPriority(int priority);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */